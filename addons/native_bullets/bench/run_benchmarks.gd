@@ -0,0 +1,93 @@
+extends SceneTree
+# Headless benchmarks of the bullets pools.
+# Build the benchmarks library with `scons platform=<platform> bench`, then run from the project folder:
+#   godot --no-window -s res://addons/native_bullets/bench/run_benchmarks.gd --bench-output=<path>
+# Use a headless (server) Godot build to keep the renderer out of the measures.
+# Results are printed as JSON and, if `--bench-output` is passed, written to that file.
+# Native checks run first, their failures are reported as errors and listed in `failed_checks`.
+
+
+const BENCH_LIBRARY = "res://addons/native_bullets/bench/bullets_bench.gdnlib"
+
+# `bullets` is the steady population, or the average one when `churn` bullets are spawned and released each frame.
+# `backend` can be "godot" (default), "none" to measure the simulation alone, or "recording" to count the server calls.
+const WORKLOADS = [
+	{ "name": "basic_steady_10k", "kit": "BasicBulletKit", "bullets": 10000 },
+	{ "name": "basic_steady_10k_no_servers", "kit": "BasicBulletKit", "bullets": 10000, "backend": "none" },
+	{ "name": "basic_steady_10k_recorded", "kit": "BasicBulletKit", "bullets": 10000, "backend": "recording" },
+	{ "name": "basic_steady_50k", "kit": "BasicBulletKit", "bullets": 50000 },
+	{ "name": "basic_steady_100k", "kit": "BasicBulletKit", "bullets": 100000 },
+	{ "name": "basic_multimesh_50k", "kit": "BasicBulletKit", "bullets": 50000, "rendering_mode": 1 },
+	{ "name": "homing_swarm_5k", "kit": "FollowingBulletKit", "bullets": 5000, "homing": true },
+	{ "name": "homing_dynamic_5k", "kit": "FollowingDynamicBulletKit", "bullets": 5000, "homing": true, "curves": true },
+	{ "name": "dynamic_curves_10k", "kit": "DynamicBulletKit", "bullets": 10000, "curves": true },
+	{ "name": "spawn_release_churn_10k", "kit": "BasicBulletKit", "bullets": 10000, "churn": 500 },
+	{ "name": "spawn_release_churn_10k_recorded", "kit": "BasicBulletKit", "bullets": 10000, "churn": 500, "backend": "recording" },
+]
+
+var library : GDNativeLibrary
+var texture : ImageTexture
+var curve : Curve
+var target : Node2D
+
+
+func _initialize():
+	library = load(BENCH_LIBRARY)
+
+	var image = Image.new()
+	image.create(8, 8, false, Image.FORMAT_RGBA8)
+	texture = ImageTexture.new()
+	texture.create_from_image(image)
+
+	curve = Curve.new()
+	curve.add_point(Vector2(0.0, 1.0))
+	curve.add_point(Vector2(0.5, 0.5))
+	curve.add_point(Vector2(1.0, 1.0))
+
+	target = Node2D.new()
+	root.add_child(target)
+
+	var benchmark = _create_native("BulletsBenchmark")
+	var failures = benchmark.run_checks(_create_kit({ "kit": "BasicBulletKit" }), root)
+	for failure in failures:
+		push_error("Check failed: " + failure)
+
+	var results = []
+	for workload in WORKLOADS:
+		var settings = workload.duplicate()
+		if settings.get("homing", false):
+			settings["target"] = target
+		results.append(benchmark.run_workload(_create_kit(workload), root, settings))
+
+	var output = JSON.print({ "engine": Engine.get_version_info()["string"], "failed_checks": failures, "results": results }, "\t")
+	print(output)
+
+	for argument in OS.get_cmdline_args():
+		if argument.begins_with("--bench-output="):
+			var file = File.new()
+			if file.open(argument.trim_prefix("--bench-output="), File.WRITE) == OK:
+				file.store_string(output)
+				file.close()
+	quit()
+
+
+func _create_native(native_class : String):
+	var script = NativeScript.new()
+	script.library = library
+	script.set_class_name(native_class)
+	return script.new()
+
+
+func _create_kit(workload : Dictionary):
+	var kit = _create_native(workload["kit"])
+	kit.material = ShaderMaterial.new()
+	kit.texture = texture
+	kit.collisions_enabled = false
+	kit.use_viewport_as_active_rect = false
+	kit.active_rect = Rect2(-4096, -4096, 8192, 8192)
+	kit.rendering_mode = workload.get("rendering_mode", 0)
+	if workload.get("curves", false):
+		# Only the properties of the used kit exist, the others are ignored.
+		for property in ["speed_multiplier_over_lifetime", "rotation_offset_over_lifetime", "speed_multiplier", "turning_speed"]:
+			kit.set(property, curve)
+	return kit
\ No newline at end of file
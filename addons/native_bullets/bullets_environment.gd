@@ -10,6 +10,26 @@ export(Array, Resource) var bullet_kits: Array
 export(Array, int) var pools_sizes: Array
 export(Array, NodePath) var parents_hints: Array
 export(Array, int) var z_indices: Array
+# Bullets allocated when mounting elastic pools, pools_sizes is their hard cap.
+export(Array, int) var pools_initial_sizes: Array
+# Bullets allocated each time an elastic pool runs out of them, 0 keeps the pool fixed.
+export(Array, int) var pools_growth_steps: Array
+# Seconds with a whole growth step unused after which an elastic pool frees memory.
+export(float, 0.0, 600.0) var pools_shrink_delay = 5.0
+# Bullets kept in the pools this environment doesn't use, so that the next environments can reuse them.
+export(int, 0, 1048576) var pools_cache_size = 0
+# Processes the pools on worker threads, committing their server calls on the main thread.
+export(bool) var multithreading = false
+# Amount of worker threads, 0 uses one less than the processor count.
+export(int, 0, 64) var threads_amount = 0
+# Cell size of the grid used by the kits colliding through the Grid collision backend.
+export(float, 1.0, 1024.0) var collision_grid_cell_size = 64.0
+# Milliseconds per frame spent building the pools when mounting, 0 builds all of them at once.
+export(float, 0.0, 100.0) var mount_time_budget = 0.0
+# Splits the shapes of the kits sharing a collision layer and mask between several physics areas,
+# one for each pool or one for each chunk of shared_areas_chunk_size shapes, instead of a single area.
+export(int, "None", "Per Pool", "Chunks") var shared_areas_split = 0
+export(int, 1, 65536) var shared_areas_chunk_size = 4096
 
 var properties_regex : RegEx
 
@@ -64,6 +84,15 @@ func _set_current(value):
 				Bullets.unmount(self)
 
 
+# Scenes saved before elastic pools existed have shorter arrays.
+func fit_elastic_arrays():
+	for array in [pools_initial_sizes, pools_growth_steps]:
+		var previous_size = array.size()
+		array.resize(bullet_kits.size())
+		for i in range(previous_size, array.size()):
+			array[i] = 0
+
+
 func _get(property: String):
 	if property == "bullet_types_amount":
 		return bullet_kits.size()
@@ -81,6 +110,10 @@ func _get(property: String):
 				return parents_hints[prop_index]
 			elif strings[1] == "z_index":
 				return z_indices[prop_index]
+			elif strings[1] == "initial_pool_size":
+				return pools_initial_sizes[prop_index] if pools_initial_sizes.size() > prop_index else 0
+			elif strings[1] == "pool_growth_step":
+				return pools_growth_steps[prop_index] if pools_growth_steps.size() > prop_index else 0
 	return null
 
 
@@ -90,6 +123,7 @@ func _set(property: String, value):
 		pools_sizes.resize(value)
 		parents_hints.resize(value)
 		z_indices.resize(value)
+		fit_elastic_arrays()
 		property_list_changed_notify()
 		return true
 	
@@ -110,6 +144,14 @@ func _set(property: String, value):
 			elif strings[1] == "z_index":
 				z_indices[prop_index] = value
 				return true
+			elif strings[1] == "initial_pool_size":
+				fit_elastic_arrays()
+				pools_initial_sizes[prop_index] = value
+				return true
+			elif strings[1] == "pool_growth_step":
+				fit_elastic_arrays()
+				pools_growth_steps[prop_index] = value
+				return true
 	return false
 
 
@@ -154,6 +196,20 @@ func _get_property_list():
 			"hint": PROPERTY_HINT_RANGE,
 			"hint_string": "-4096,4096"
 		})
+		properties.append({
+			"name": "bullet_type_{0}/initial_pool_size".format(format_array),
+			"type": TYPE_INT,
+			"usage": PROPERTY_USAGE_DEFAULT,
+			"hint": PROPERTY_HINT_RANGE,
+			"hint_string": "0,65536"
+		})
+		properties.append({
+			"name": "bullet_type_{0}/pool_growth_step".format(format_array),
+			"type": TYPE_INT,
+			"usage": PROPERTY_USAGE_DEFAULT,
+			"hint": PROPERTY_HINT_RANGE,
+			"hint_string": "0,65536"
+		})
 		properties.append({
 			"name": "bullet_type_{0}/controls".format(format_array),
 			"type": TYPE_NIL,
@@ -33,6 +33,8 @@ func parse_property(object, type, path, hint, hint_text, usage):
 		return true
 	elif path == "collision_mask" and not object.collisions_enabled:
 		return true
+	elif path == "collision_backend" and not object.collisions_enabled:
+		return true
 	elif path == "active_rect" and object.use_viewport_as_active_rect:
 		return true
 	elif path == "rotate":
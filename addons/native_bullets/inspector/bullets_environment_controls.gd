@@ -41,38 +41,55 @@ func _draw():
 
 
 func _on_move_up_pressed():
+	object.fit_elastic_arrays()
 	var bullet_kit = object.bullet_kits[index]
 	var pool_size = object.pools_sizes[index]
 	var z_index = object.z_indices[index]
+	var initial_pool_size = object.pools_initial_sizes[index]
+	var pool_growth_step = object.pools_growth_steps[index]
 	
 	object.bullet_kits.remove(index)
 	object.pools_sizes.remove(index)
 	object.z_indices.remove(index)
+	object.pools_initial_sizes.remove(index)
+	object.pools_growth_steps.remove(index)
 	object.bullet_kits.insert(index -1, bullet_kit)
 	object.pools_sizes.insert(index - 1, pool_size)
 	object.z_indices.insert(index - 1, z_index)
+	object.pools_initial_sizes.insert(index - 1, initial_pool_size)
+	object.pools_growth_steps.insert(index - 1, pool_growth_step)
 	
 	object.property_list_changed_notify()
 
 
 func _on_move_down_pressed():
+	object.fit_elastic_arrays()
 	var bullet_kit = object.bullet_kits[index]
 	var pool_size = object.pools_sizes[index]
 	var z_index = object.z_indices[index]
+	var initial_pool_size = object.pools_initial_sizes[index]
+	var pool_growth_step = object.pools_growth_steps[index]
 	
 	object.bullet_kits.remove(index)
 	object.pools_sizes.remove(index)
 	object.z_indices.remove(index)
+	object.pools_initial_sizes.remove(index)
+	object.pools_growth_steps.remove(index)
 	object.bullet_kits.insert(index + 1, bullet_kit)
 	object.pools_sizes.insert(index + 1, pool_size)
 	object.z_indices.insert(index + 1, z_index)
+	object.pools_initial_sizes.insert(index + 1, initial_pool_size)
+	object.pools_growth_steps.insert(index + 1, pool_growth_step)
 	
 	object.property_list_changed_notify()
 
 
 func _on_delete_pressed():
+	object.fit_elastic_arrays()
 	object.bullet_kits.remove(index)
 	object.pools_sizes.remove(index)
 	object.z_indices.remove(index)
+	object.pools_initial_sizes.remove(index)
+	object.pools_growth_steps.remove(index)
 	
 	object.property_list_changed_notify()
@@ -20,7 +20,8 @@ func can_handle(object):
 
 
 func parse_property(object, type, path, hint, hint_text, usage):
-	if path == "bullet_kits" or path == "pools_sizes" or path == "parents_hints" or path == "z_indices":
+	if path == "bullet_kits" or path == "pools_sizes" or path == "parents_hints" or path == "z_indices" or \
+			path == "pools_initial_sizes" or path == "pools_growth_steps":
 		return true
 	
 	var result = properties_regex.search(path)
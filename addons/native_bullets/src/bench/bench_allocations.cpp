@@ -0,0 +1,146 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#include "bullets_benchmark.h"
+
+
+// Replacing the global operator new only affects this library, so the count only covers the plugin code.
+// Every form is replaced, so that the count doesn't depend on which ones the standard library forwards to the others.
+static std::atomic<int64_t> allocations(0);
+
+int64_t get_bench_allocations() {
+	return allocations.load(std::memory_order_relaxed);
+}
+
+static void* bench_allocate(std::size_t size) {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	return std::malloc(size > 0 ? size : 1);
+}
+
+void* operator new(std::size_t size) {
+	void* pointer = bench_allocate(size);
+	if(pointer == nullptr) {
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new[](std::size_t size) {
+	void* pointer = bench_allocate(size);
+	if(pointer == nullptr) {
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+	return bench_allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+	return bench_allocate(size);
+}
+
+void operator delete(void* pointer) noexcept {
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t size) noexcept {
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t size) noexcept {
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+	std::free(pointer);
+}
+
+#ifdef __cpp_aligned_new
+// Aligned blocks can't be released with std::free on Windows, they have their own allocator.
+static void* bench_allocate_aligned(std::size_t size, std::align_val_t alignment) {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	size = size > 0 ? size : 1;
+#ifdef _WIN32
+	return _aligned_malloc(size, (std::size_t)alignment);
+#else
+	// posix_memalign needs at least the alignment of a pointer.
+	std::size_t pointer_alignment = (std::size_t)alignment > sizeof(void*) ? (std::size_t)alignment : sizeof(void*);
+	void* pointer = nullptr;
+	if(posix_memalign(&pointer, pointer_alignment, size) != 0) {
+		return nullptr;
+	}
+	return pointer;
+#endif
+}
+
+static void bench_free_aligned(void* pointer) {
+#ifdef _WIN32
+	_aligned_free(pointer);
+#else
+	std::free(pointer);
+#endif
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+	void* pointer = bench_allocate_aligned(size, alignment);
+	if(pointer == nullptr) {
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+	void* pointer = bench_allocate_aligned(size, alignment);
+	if(pointer == nullptr) {
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	return bench_allocate_aligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	return bench_allocate_aligned(size, alignment);
+}
+
+void operator delete(void* pointer, std::align_val_t alignment) noexcept {
+	bench_free_aligned(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t alignment) noexcept {
+	bench_free_aligned(pointer);
+}
+
+void operator delete(void* pointer, std::size_t size, std::align_val_t alignment) noexcept {
+	bench_free_aligned(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t size, std::align_val_t alignment) noexcept {
+	bench_free_aligned(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	bench_free_aligned(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	bench_free_aligned(pointer);
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include <chrono>
+#include <cmath>
+#include <memory>
+
+#include "bullets_benchmark.h"
+#include "../bullets_server_backend.h"
+
+using namespace godot;
+
+
+void BulletsBenchmark::_register_methods() {
+	register_method("run_workload", &BulletsBenchmark::run_workload);
+	register_method("run_checks", &BulletsBenchmark::run_checks);
+}
+
+int32_t BulletsBenchmark::_get_int(const Dictionary& workload, const String& key, int32_t default_value) {
+	return workload.has(key) ? (int32_t)workload[key] : default_value;
+}
+
+Dictionary BulletsBenchmark::run_workload(Ref<BulletKit> kit, Node* parent_hint, Dictionary workload) {
+	Dictionary results;
+	if(kit.is_null() || !kit->is_valid()) {
+		ERR_PRINT("The benchmarked BulletKit is not valid!");
+		return results;
+	}
+	if(kit->collisions_enabled && kit->collision_backend == 0) {
+		// There is no shared area outside of a Bullets node.
+		ERR_PRINT("Benchmarked kits can't use the Physics Server collision backend!");
+		return results;
+	}
+	// Steady workloads spawn `bullets` bullets once, then keep them alive.
+	// Churn workloads spawn `churn` bullets each frame, fast enough to leave the active rect after bullets / churn frames.
+	int32_t bullets = Math::max(_get_int(workload, "bullets", 10000), 1);
+	int32_t churn = Math::max(_get_int(workload, "churn", 0), 0);
+	int32_t frames = Math::max(_get_int(workload, "frames", 300), 1);
+	int32_t warmup_frames = Math::max(_get_int(workload, "warmup_frames", 60), 0);
+	const float delta = 1.0f / 60.0f;
+
+	Rect2 rect = kit->active_rect;
+	Vector2 center = rect.position + rect.size / 2.0f;
+	float speed = 100.0f;
+	if(churn > 0) {
+		float lifetime_frames = (float)bullets / churn;
+		speed = Math::min(rect.size.x, rect.size.y) / 2.0f / (lifetime_frames * delta);
+		// Bullets moving diagonally live longer, the population settles above `bullets`.
+		warmup_frames = Math::max(warmup_frames, (int32_t)(lifetime_frames * 2.0f));
+	}
+
+	// `backend` selects where the server calls go: "godot" forwards them to the engine, "none" drops them,
+	// "recording" counts them before forwarding them to the engine.
+	String backend_name = workload.has("backend") ? (String)workload["backend"] : String("godot");
+	NullServerBackend null_backend;
+	RecordingServerBackend recording_backend(BulletsServerBackend::get_godot_backend());
+	bool recording = backend_name == "recording";
+
+	std::unique_ptr<BulletsPool> pool = kit->_create_pool();
+	if(backend_name == "none") {
+		pool->_set_server_backend(&null_backend);
+	} else if(recording) {
+		pool->_set_server_backend(&recording_backend);
+	}
+	int32_t pool_size = churn > 0 ? bullets * 3 / 2 + churn : bullets;
+	pool->_init(parent_hint, BulletsPoolAreas(RID()), 0, 0, kit, pool_size, 0);
+
+	// Bullets are spread with a fixed pattern, so that runs are comparable.
+	int32_t spawned = 0;
+	auto spawn = [&]() {
+		float angle = spawned * 2.39996323f;
+		Vector2 direction = Vector2(std::cos(angle), std::sin(angle));
+		Vector2 position = center;
+		if(churn == 0) {
+			position += Vector2(std::fmod(spawned * 0.7548777f, 1.0f) - 0.5f, std::fmod(spawned * 0.5698403f, 1.0f) - 0.5f) * 1024.0f;
+		}
+		Dictionary properties;
+		properties["transform"] = Transform2D(angle, position);
+		properties["velocity"] = direction * speed;
+		if(workload.has("target")) {
+			properties["target_node"] = workload["target"];
+		}
+		pool->spawn_bullet(properties);
+		spawned++;
+	};
+	if(churn == 0) {
+		for(int32_t i = 0; i < bullets; i++) {
+			spawn();
+		}
+	}
+
+	int64_t elapsed_ns = 0;
+	int64_t allocations = 0;
+	int64_t processed_bullets = 0;
+
+	for(int32_t frame = -warmup_frames; frame < frames; frame++) {
+		if(frame == 0) {
+			recording_backend.reset();
+		}
+		int64_t allocations_before = get_bench_allocations();
+		auto start = std::chrono::steady_clock::now();
+
+		for(int32_t i = 0; i < churn; i++) {
+			spawn();
+		}
+		int32_t active_bullets = pool->get_active_bullets();
+		pool->_update_active_rect();
+		pool->_prepare_simulation();
+		pool->_process(delta);
+		pool->_flush_shape_changes();
+		pool->_update_multimesh();
+
+		auto end = std::chrono::steady_clock::now();
+		if(frame >= 0) {
+			elapsed_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+			allocations += get_bench_allocations() - allocations_before;
+			processed_bullets += active_bullets;
+		}
+	}
+
+	results["name"] = workload.has("name") ? workload["name"] : Variant("");
+	results["bullets"] = (int64_t)(processed_bullets / frames);
+	results["churn"] = churn;
+	results["frames"] = frames;
+	results["ns_per_frame"] = (double)elapsed_ns / frames;
+	results["ns_per_bullet"] = processed_bullets > 0 ? (double)elapsed_ns / processed_bullets : 0.0;
+	results["allocations_per_frame"] = (double)allocations / frames;
+	results["backend"] = backend_name;
+	if(recording) {
+		results["server_calls_per_frame"] = (double)recording_backend.get_total_calls() / frames;
+		results["server_calls"] = recording_backend.get_calls_dictionary();
+	}
+	return results;
+}
\ No newline at end of file
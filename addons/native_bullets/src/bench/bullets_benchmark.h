@@ -0,0 +1,38 @@
+#ifndef BULLETS_BENCHMARK_H
+#define BULLETS_BENCHMARK_H
+
+#include <Godot.hpp>
+#include <Reference.hpp>
+#include <Node.hpp>
+
+#include "../bullet_kit.h"
+
+using namespace godot;
+
+
+// Number of allocations made through the global operator new by the benchmarks library.
+// Engine allocations, like the ones of Dictionary or Array, are not counted.
+int64_t get_bench_allocations();
+
+// Runs scripted workloads over a single bullets pool, outside of a Bullets node, and measures them.
+// Only built into the benchmarks library, used by bench/run_benchmarks.gd.
+class BulletsBenchmark : public Reference {
+	GODOT_CLASS(BulletsBenchmark, Reference)
+
+private:
+	int32_t _get_int(const Dictionary& workload, const String& key, int32_t default_value);
+
+public:
+	void _init() {}
+
+	// Processes a pool of `kit` bullets as described by `workload`, returns the measured results.
+	// `parent_hint` is used to find the canvas the bullets are drawn in.
+	Dictionary run_workload(Ref<BulletKit> kit, Node* parent_hint, Dictionary workload);
+	// Checks the behaviour the workloads rely on, returns a description of each failed check.
+	// `kit` must be a valid kit without collision shape, its bullets are tested as points.
+	Array run_checks(Ref<BulletKit> kit, Node* parent_hint);
+
+	static void _register_methods();
+};
+
+#endif
\ No newline at end of file
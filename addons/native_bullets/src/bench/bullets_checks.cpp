@@ -0,0 +1,78 @@
+#include <memory>
+#include <cmath>
+
+#include "bullets_benchmark.h"
+#include "../bullets_grid.h"
+#include "../bullets_server_backend.h"
+
+using namespace godot;
+
+
+Array BulletsBenchmark::run_checks(Ref<BulletKit> kit, Node* parent_hint) {
+	Array failures;
+	auto check = [&](bool passed, const String& description) {
+		if(!passed) {
+			failures.append(description);
+		}
+	};
+
+	// Bullets without a supported shape are queried as points, a circle without radius.
+	BulletsGrid grid;
+	BulletsGridShape point;
+	grid.add_bullet(BulletID(0, 0, 0), UINT32_MAX, point, Transform2D(0.0f, Vector2(50.0f, 0.0f)));
+	grid.add_bullet(BulletID(1, 0, 0), UINT32_MAX, point, Transform2D(0.0f, Vector2(50.0f, 10.0f)));
+	grid.build();
+
+	std::vector<BulletID> hits;
+	BulletsGridShape rect;
+	rect.circle = false;
+	rect.extents = Vector2(60.0f, 5.0f);
+	grid.query(rect, Transform2D(0.0f, Vector2()), UINT32_MAX, hits);
+	check(hits.size() == 1 && hits[0].index == 0, "A rect query finds the points inside it");
+
+	hits.clear();
+	BulletsGridShape segment;
+	segment.circle = false;
+	segment.extents = Vector2(50.0f, 0.0f);
+	grid.query(segment, Transform2D(0.0f, Vector2(50.0f, 0.0f)), UINT32_MAX, hits);
+	check(hits.size() == 1 && hits[0].index == 0, "A segment query finds the points on it");
+
+	hits.clear();
+	grid.query(point, Transform2D(0.0f, Vector2(50.0f, 10.0f)), UINT32_MAX, hits);
+	check(hits.size() == 1 && hits[0].index == 1, "A point query finds the points at the same position");
+
+	// Areas too large for the cell coordinates fall back to testing every entry.
+	hits.clear();
+	BulletsGridShape infinite_circle;
+	infinite_circle.radius = INFINITY;
+	grid.query(infinite_circle, Transform2D(0.0f, Vector2()), UINT32_MAX, hits);
+	check(hits.size() == 2, "An infinite circle query finds every bullet");
+
+	hits.clear();
+	BulletsGridShape huge_rect;
+	huge_rect.circle = false;
+	huge_rect.extents = Vector2(1e30f, 1e30f);
+	grid.query(huge_rect, Transform2D(0.0f, Vector2()), UINT32_MAX, hits);
+	check(hits.size() == 2, "A rect query larger than the cell range finds every bullet");
+
+	if(kit.is_null() || !kit->is_valid() || kit->collision_shape.is_valid()) {
+		failures.append("The checked BulletKit is not valid!");
+		return failures;
+	}
+	NullServerBackend null_backend;
+	std::unique_ptr<BulletsPool> pool = kit->_create_pool();
+	pool->_set_server_backend(&null_backend);
+	pool->_init(parent_hint, BulletsPoolAreas(RID()), 0, 0, kit, 16, 0);
+
+	const Vector2 positions[3] = { Vector2(0.0f, 0.0f), Vector2(50.0f, 0.0f), Vector2(50.0f, 10.0f) };
+	pool->spawn_bullets(positions, nullptr, nullptr, 3);
+	check(pool->release_in_shape(rect, Transform2D(0.0f, Vector2())) == 2, "A rect wipe releases the points inside it");
+	check(pool->get_active_bullets() == 1, "A rect wipe keeps the points outside of it");
+
+	BulletsGridShape circle;
+	circle.radius = 10.0f;
+	check(pool->release_in_shape(circle, Transform2D(0.0f, Vector2(50.0f, 0.0f))) == 1, "A circle wipe releases the points on its boundary");
+	check(pool->get_active_bullets() == 0, "A circle wipe leaves no bullet behind");
+
+	return failures;
+}
\ No newline at end of file
@@ -14,8 +14,29 @@ struct BulletID {
 
 	BulletID(int32_t index, int32_t cycle, int32_t set): 
 		index(index), cycle(cycle), set(set) {}
+
+	// IDs can also be packed in a single integer handle: the index in the lowest 24 bits,
+	// the set in the next 8 and the cycle in the highest 32. Invalid IDs are packed as -1.
+	static const int32_t MAX_INDEX = (1 << 24) - 1;
+	static const int32_t MAX_SET = (1 << 8) - 1;
+
+	int64_t to_handle() const {
+		if(index < 0 || set < 0) {
+			return -1;
+		}
+		return (int64_t)(((uint64_t)(uint32_t)cycle << 32) | ((uint64_t)(set & MAX_SET) << 24) | (uint64_t)(index & MAX_INDEX));
+	}
+
+	static BulletID from_handle(int64_t handle) {
+		if(handle < 0) {
+			return BulletID(-1, -1, -1);
+		}
+		return BulletID((int32_t)(handle & MAX_INDEX), (int32_t)(handle >> 32), (int32_t)((handle >> 24) & MAX_SET));
+	}
 };
 
+// Pools store bullets as per-field arrays, a Bullet object is only used as a proxy
+// to expose the properties of a single bullet to scripts.
 class Bullet : public Object {
 	GODOT_CLASS(Bullet, Object)
 
@@ -8,6 +8,7 @@
 #include <Texture.hpp>
 #include <PackedScene.hpp>
 #include <Script.hpp>
+#include <Curve.hpp>
 
 #include <memory>
 
@@ -43,6 +44,9 @@ public:
 	int32_t collision_layer = 0;
 	int32_t collision_mask = 0;
 	Ref<Shape2D> collision_shape;
+	// Controls which system detects the collisions: Physics2DServer areas, or the plugin grid queried by the registered hurtboxes.
+	// The grid only supports CircleShape2D and RectangleShape2D.
+	int32_t collision_backend = 0;
 	// Controls whether the active rect is automatically set as the viewport visible rect.
 	bool use_viewport_as_active_rect = true;
 	// Controls where the bullets can live, if a bullet exits this rect, it will be removed.
@@ -52,14 +56,26 @@ public:
 	// Allows the ability to have a unique-ish value in each instance of the bullet material.
 	// Can be used to offset the bullets animation by a unique amount to avoid having them animate in sync.
 	int32_t unique_modulate_component = 0;
+	// Controls how bullets are drawn: using a canvas item each, or a single MultiMesh per pool drawn in one batch.
+	int32_t rendering_mode = 0;
+	// If enabled, bullets stay where they are spawned: they are not moved, rotated or removed outside the active rect.
+	// Only their lifetime increases, scripts can still move them. Stationary hazards cost almost nothing per frame.
+	bool static_bullets = false;
 	// Additional data the user can set via the editor.
 	Variant data;
+	// Assigned by Bullets when the kit is mounted, used to find its pool in constant time. Not exposed to scripts.
+	int32_t kit_slot = -1;
 
 	void _init() {}
 
 	void _property_setter(String value) {}
 	String _property_getter() { return ""; }
 
+	// Called when one of the curves assigned with _set_curve is edited.
+	void _on_curve_changed() { _bake_curves(); }
+	// Kits sampling curves while processing bake them here into lookup tables.
+	virtual void _bake_curves() {}
+
 	static void _register_methods() {
 		register_property<BulletKit, Ref<Material>>("material", &BulletKit::material,
 			Ref<Material>(), GODOT_METHOD_RPC_MODE_DISABLED, GODOT_PROPERTY_USAGE_DEFAULT,
@@ -74,6 +90,8 @@ public:
 		register_property<BulletKit, Ref<Shape2D>>("collision_shape", &BulletKit::collision_shape,
 			Ref<Shape2D>(), GODOT_METHOD_RPC_MODE_DISABLED,GODOT_PROPERTY_USAGE_DEFAULT,
 			GODOT_PROPERTY_HINT_RESOURCE_TYPE, "Shape2D");
+		register_property<BulletKit, int32_t>("collision_backend", &BulletKit::collision_backend, 0,
+			GODOT_METHOD_RPC_MODE_DISABLED, GODOT_PROPERTY_USAGE_DEFAULT, GODOT_PROPERTY_HINT_ENUM, "Physics Server,Grid");
 		register_property<BulletKit, bool>("use_viewport_as_active_rect", &BulletKit::use_viewport_as_active_rect, true,
 			GODOT_METHOD_RPC_MODE_DISABLED, (godot_property_usage_flags)(GODOT_PROPERTY_USAGE_DEFAULT | GODOT_PROPERTY_USAGE_UPDATE_ALL_IF_MODIFIED),
 			GODOT_PROPERTY_HINT_NONE);
@@ -84,6 +102,10 @@ public:
 			GODOT_PROPERTY_HINT_NONE);
 		register_property<BulletKit, int32_t>("unique_modulate_component", &BulletKit::unique_modulate_component, 0,
 			GODOT_METHOD_RPC_MODE_DISABLED, GODOT_PROPERTY_USAGE_DEFAULT, GODOT_PROPERTY_HINT_ENUM, "None,Red,Green,Blue,Alpha");
+		register_property<BulletKit, int32_t>("rendering_mode", &BulletKit::rendering_mode, 0,
+			GODOT_METHOD_RPC_MODE_DISABLED, GODOT_PROPERTY_USAGE_DEFAULT, GODOT_PROPERTY_HINT_ENUM, "Canvas Items,MultiMesh");
+		register_property<BulletKit, bool>("static_bullets", &BulletKit::static_bullets, false,
+			GODOT_METHOD_RPC_MODE_DISABLED, GODOT_PROPERTY_USAGE_DEFAULT, GODOT_PROPERTY_HINT_NONE);
 		register_property<BulletKit, Variant>("data", &BulletKit::data, Dictionary(),
 			GODOT_METHOD_RPC_MODE_DISABLED, (godot_property_usage_flags)(GODOT_PROPERTY_USAGE_DEFAULT | GODOT_PROPERTY_USAGE_UPDATE_ALL_IF_MODIFIED),
 			GODOT_PROPERTY_HINT_NONE);
@@ -94,11 +116,30 @@ public:
 		register_property<BulletKit, String>("bullet_properties",
 			&BulletKit::_property_setter, &BulletKit::_property_getter, "",
 			GODOT_METHOD_RPC_MODE_DISABLED, GODOT_PROPERTY_USAGE_EDITOR);
+
+		register_method("_on_curve_changed", &BulletKit::_on_curve_changed);
 	}
 
 	virtual bool is_valid() { return material.is_valid(); }
 
 	virtual std::unique_ptr<BulletsPool> _create_pool() { return std::unique_ptr<BulletsPool>(); }
+
+protected:
+	// Assigns a curve property, keeping the kit connected to the `changed` signal of the curves it uses.
+	// The connection is reference counted since the same curve can be assigned to more than one property.
+	void _set_curve(Ref<Curve>& property, Ref<Curve> curve) {
+		if(property == curve) {
+			return;
+		}
+		if(property.is_valid()) {
+			property->disconnect("changed", this, "_on_curve_changed");
+		}
+		property = curve;
+		if(property.is_valid()) {
+			property->connect("changed", this, "_on_curve_changed", Array(), Object::CONNECT_REFERENCE_COUNTED);
+		}
+		_bake_curves();
+	}
 };
 
 #include "bullets_pool.h"
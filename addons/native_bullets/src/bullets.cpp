@@ -7,21 +7,36 @@
 #include <Font.hpp>
 #include <RegExMatch.hpp>
 
+#include <chrono>
+#include <algorithm>
+
 #include "bullets.h"
 
 using namespace godot;
 
 
 void Bullets::_register_methods() {
+	register_method("_process", &Bullets::_process);
 	register_method("_physics_process", &Bullets::_physics_process);
+	register_method("_flush_shape_changes", &Bullets::_flush_shape_changes);
 
 	register_method("mount", &Bullets::mount);
 	register_method("unmount", &Bullets::unmount);
 	register_method("get_bullets_environment", &Bullets::get_bullets_environment);
+	register_method("is_mounting", &Bullets::is_mounting);
+	register_method("clear_pool_cache", &Bullets::clear_pool_cache);
 
 	register_method("spawn_bullet", &Bullets::spawn_bullet);
+	register_method("spawn_bullets", &Bullets::spawn_bullets);
 	register_method("obtain_bullet", &Bullets::obtain_bullet);
+	register_method("obtain_bullet_handle", &Bullets::obtain_bullet_handle);
 	register_method("release_bullet", &Bullets::release_bullet);
+	register_method("release_all", &Bullets::release_all);
+	register_method("release_kit", &Bullets::release_kit);
+	register_method("release_in_rect", &Bullets::release_in_rect);
+	register_method("release_in_circle", &Bullets::release_in_circle);
+	register_method("release_older_than", &Bullets::release_older_than);
+	register_method("release_by_predicate", &Bullets::release_by_predicate);
 
 	register_method("is_bullet_valid", &Bullets::is_bullet_valid);
 	register_method("is_kit_valid", &Bullets::is_kit_valid);
@@ -33,19 +48,36 @@ void Bullets::_register_methods() {
 
 	register_method("get_total_available_bullets", &Bullets::get_total_available_bullets);
 	register_method("get_total_active_bullets", &Bullets::get_total_active_bullets);
+	register_method("get_frame_stats", &Bullets::get_frame_stats);
 
 	register_method("is_bullet_existing", &Bullets::is_bullet_existing);
 	register_method("get_bullet_from_shape", &Bullets::get_bullet_from_shape);
+	register_method("get_bullet_handle_from_shape", &Bullets::get_bullet_handle_from_shape);
 	register_method("get_kit_from_bullet", &Bullets::get_kit_from_bullet);
 
+	register_method("schedule_event", &Bullets::schedule_event);
+	register_method("cancel_event", &Bullets::cancel_event);
+	register_method("set_event_interval", &Bullets::set_event_interval);
+	register_method("is_event_scheduled", &Bullets::is_event_scheduled);
+
+	register_method("query_circle", &Bullets::query_circle);
+	register_method("query_rect", &Bullets::query_rect);
+	register_method("query_segment", &Bullets::query_segment);
+
+	register_method("add_hurtbox", &Bullets::add_hurtbox);
+	register_method("remove_hurtbox", &Bullets::remove_hurtbox);
+	register_method("get_hits", &Bullets::get_hits);
+
 	register_method("set_bullet_property", &Bullets::set_bullet_property);
 	register_method("get_bullet_property", &Bullets::get_bullet_property);
+
+	register_signal<Bullets>((char *)"mounted", "bullets_environment", GODOT_VARIANT_TYPE_OBJECT);
 }
 
 Bullets::Bullets() { }
 
 Bullets::~Bullets() {
-	_clear_rids();
+	_clear_pool_sets();
 }
 
 void Bullets::_init() {
@@ -59,38 +91,208 @@ void Bullets::_init() {
 	invalid_id.set(2, -1);
 }
 
+void Bullets::_process(float delta) {
+	if(Engine::get_singleton()->is_editor_hint()) {
+		return;
+	}
+	// Pools using the MultiMesh rendering mode upload their instances once per frame.
+	for(int32_t i = 0; i < pool_sets.size(); i++) {
+		for(int32_t j = 0; j < pool_sets[i].ready_pools; j++) {
+			pool_sets[i].pools[j].pool->_update_multimesh();
+		}
+	}
+}
+
 void Bullets::_physics_process(float delta) {
 	if(Engine::get_singleton()->is_editor_hint()) {
 		return;
 	}
+	if(mounting) {
+		_mount_pending_pools();
+	}
 	int32_t bullets_variation = 0;
+	bool multithreading = thread_pool.get_threads_amount() > 0;
+	parallel_pools.clear();
 
 	for(int32_t i = 0; i < pool_sets.size(); i++) {
-		for(int32_t j = 0; j < pool_sets[i].pools.size(); j++) {
-			bullets_variation = pool_sets[i].pools[j].pool->_process(delta);
+		for(int32_t j = 0; j < pool_sets[i].ready_pools; j++) {
+			BulletsPool* pool = pool_sets[i].pools[j].pool.get();
+			pool->_update_texture();
+			pool->_update_active_rect();
+			pool->_prepare_simulation();
+
+			// Static pools have too little to do to be worth a job.
+			if(multithreading && pool->_is_thread_safe() && !pool->_has_static_bullets()) {
+				parallel_pools.push_back(pool);
+				continue;
+			}
+			bullets_variation = pool->_process(delta);
 			available_bullets -= bullets_variation;
 			active_bullets += bullets_variation;
 		}
 	}
+	if(!parallel_pools.empty()) {
+		_process_parallel_pools(delta);
+	}
+	_update_collision_grid();
+	// Bullets spawned by the events count in the stats of this tick.
+	scheduler.process(delta);
+	query_grid_dirty = true;
+	_flush_shape_changes();
+	// Nodes processed after this one can spawn and release bullets too, flush again before the physics step.
+	call_deferred("_flush_shape_changes");
+
+	for(int32_t i = 0; i < pool_sets.size(); i++) {
+		for(int32_t j = 0; j < pool_sets[i].ready_pools; j++) {
+			pool_sets[i].pools[j].pool->_end_frame_stats();
+			pool_sets[i].pools[j].pool->_update_capacity(delta);
+		}
+	}
 }
 
-void Bullets::_clear_rids() {
-	for(int32_t i = 0; i < shared_areas.size(); i++) {
-		Physics2DServer::get_singleton()->area_clear_shapes(shared_areas[i]);
-		Physics2DServer::get_singleton()->free_rid(shared_areas[i]);
+void Bullets::_flush_shape_changes() {
+	for(int32_t i = 0; i < pool_sets.size(); i++) {
+		for(int32_t j = 0; j < pool_sets[i].ready_pools; j++) {
+			pool_sets[i].pools[j].pool->_flush_shape_changes();
+		}
 	}
 }
 
-int32_t Bullets::_get_pool_index(int32_t set_index, int32_t bullet_index) {
-	if(bullet_index >= 0 && set_index >= 0 && set_index < pool_sets.size() && bullet_index < pool_sets[set_index].bullets_amount) {
-		int32_t pool_threshold = pool_sets[set_index].pools[0].size;
-		int32_t pool_index = 0;
+void Bullets::_process_parallel_pools(float delta) {
+	// Start from the busiest pools, so that the chunks and commits of the smaller ones fill the gaps at the end.
+	std::sort(parallel_pools.begin(), parallel_pools.end(), [](BulletsPool* a, BulletsPool* b) {
+		return a->get_active_bullets() > b->get_active_bullets();
+	});
+	simulation_chunks.clear();
+	for(int32_t i = 0; i < parallel_pools.size(); i++) {
+		int32_t active = parallel_pools[i]->get_active_bullets();
+		for(int32_t begin = 0; begin < active; begin += SIMULATION_CHUNK_SIZE) {
+			simulation_chunks.push_back({ parallel_pools[i], begin, Math::min(begin + SIMULATION_CHUNK_SIZE, active), 0 });
+		}
+	}
+	parallel_variations.resize(parallel_pools.size());
+	parallel_commit_usecs.resize(parallel_pools.size());
+
+	thread_pool.parallel_for(simulation_chunks.size(), [&](int32_t job) {
+		SimulationChunk& chunk = simulation_chunks[job];
+		auto start = std::chrono::steady_clock::now();
+		chunk.pool->_simulate(delta, chunk.begin, chunk.end);
+		chunk.usec = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+	});
+	// Releases reorder a whole pool, so each pool is committed by a single thread.
+	thread_pool.parallel_for(parallel_pools.size(), [&](int32_t job) {
+		auto start = std::chrono::steady_clock::now();
+		parallel_pools[job]->_set_deferring_server_commands(true);
+		parallel_variations[job] = parallel_pools[job]->_commit();
+		parallel_pools[job]->_set_deferring_server_commands(false);
+		parallel_commit_usecs[job] = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+	});
+	// Times of the chunks are summed, they measure the work done on the pool rather than the elapsed time.
+	for(int32_t i = 0; i < simulation_chunks.size(); i++) {
+		simulation_chunks[i].pool->_add_frame_times(simulation_chunks[i].usec, 0);
+	}
+
+	// Servers are not thread-safe, commit what the pools recorded from the main thread.
+	for(int32_t i = 0; i < parallel_pools.size(); i++) {
+		auto start = std::chrono::steady_clock::now();
+		parallel_pools[i]->_flush_server_commands();
+		parallel_commit_usecs[i] += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+		parallel_pools[i]->_add_frame_times(0, parallel_commit_usecs[i]);
+
+		available_bullets -= parallel_variations[i];
+		active_bullets += parallel_variations[i];
+	}
+}
+
+void Bullets::_update_collision_grid() {
+	// Arrays are shared, scripts could still hold the hits of the previous tick.
+	hits = Array();
+	if(!grid_enabled) {
+		return;
+	}
+	collision_grid.clear();
+	for(int32_t i = 0; i < pool_sets.size(); i++) {
+		for(int32_t j = 0; j < pool_sets[i].ready_pools; j++) {
+			pool_sets[i].pools[j].pool->_add_to_grid(collision_grid);
+		}
+	}
+	collision_grid.build();
+
+	for(int32_t i = hurtboxes.size() - 1; i >= 0; i--) {
+		godot_object* instance = godot::core_1_2_api->godot_instance_from_id(hurtboxes[i].instance_id);
+		if(instance == nullptr) {
+			// The hurtbox node has been freed without being removed.
+			hurtboxes[i] = hurtboxes.back();
+			hurtboxes.pop_back();
+			continue;
+		}
+		Node2D* node = godot::detail::get_wrapper<Node2D>(instance);
 
-		while(bullet_index >= pool_threshold) {
-			pool_index++;
-			pool_threshold += pool_sets[set_index].pools[pool_index].size;
+		hurtbox_hits.clear();
+		collision_grid.query(hurtboxes[i].shape, node->get_global_transform(), hurtboxes[i].collision_mask, hurtbox_hits);
+		for(int32_t j = 0; j < hurtbox_hits.size(); j++) {
+			hits.append(node);
+			hits.append(_to_pool_int_array(hurtbox_hits[j]));
+		}
+	}
+}
+
+BulletID Bullets::_to_bullet_id(Variant id) {
+	// Accept both the packed integer handles and the PoolIntArray IDs.
+	if(id.get_type() == Variant::INT) {
+		return BulletID::from_handle(id);
+	}
+	if(id.get_type() == Variant::POOL_INT_ARRAY) {
+		PoolIntArray bullet_id = id;
+		if(bullet_id.size() == 3) {
+			return BulletID(bullet_id[0], bullet_id[1], bullet_id[2]);
 		}
-		if(pool_index < pool_sets[set_index].pools.size()) {
+	}
+	return BulletID(-1, -1, -1);
+}
+
+PoolIntArray Bullets::_to_pool_int_array(BulletID id) {
+	PoolIntArray to_return = invalid_id;
+	to_return.set(0, id.index);
+	to_return.set(1, id.cycle);
+	to_return.set(2, id.set);
+	return to_return;
+}
+
+void Bullets::_clear_kit_slots() {
+	for(int32_t i = 0; i < kit_slots.size(); i++) {
+		kit_slots[i].kit->kit_slot = -1;
+	}
+	kit_slots.clear();
+}
+
+Bullets::PoolKit* Bullets::_get_pool_kit(const Ref<BulletKit>& kit) {
+	if(kit.is_null()) {
+		return nullptr;
+	}
+	int32_t slot = kit->kit_slot;
+	// The slot could have been assigned by another Bullets node, check that it really belongs to the kit.
+	if(slot >= 0 && slot < kit_slots.size() && kit_slots[slot].kit == kit.ptr() &&
+			kit_slots[slot].pool_index < pool_sets[kit_slots[slot].set_index].ready_pools) {
+		return &pool_sets[kit_slots[slot].set_index].pools[kit_slots[slot].pool_index];
+	}
+	return nullptr;
+}
+
+int32_t Bullets::_get_pool_set_index(RID area_rid, int32_t& shape_index) {
+	auto area_slot = areas_to_pool_set_indices.find(area_rid.get_id());
+	if(area_slot == areas_to_pool_set_indices.end()) {
+		return -1;
+	}
+	shape_index += area_slot->second.first_shape_index;
+	return area_slot->second.set_index;
+}
+
+int32_t Bullets::_get_pool_index(int32_t set_index, int32_t bullet_index) {
+	if(bullet_index >= 0 && set_index >= 0 && set_index < pool_sets.size() && bullet_index < pool_sets[set_index].bullets_amount) {
+		int32_t pool_index = pool_sets[set_index].shapes_to_pools[bullet_index];
+		// Pools still waiting for a time-sliced mount have no bullets yet.
+		if(pool_index < pool_sets[set_index].ready_pools) {
 			return pool_index;
 		}
 	}
@@ -98,34 +300,55 @@ int32_t Bullets::_get_pool_index(int32_t set_index, int32_t bullet_index) {
 }
 
 void Bullets::mount(Node* bullets_environment) {
-	if(bullets_environment == nullptr || this->bullets_environment == bullets_environment) {
+	if(bullets_environment == nullptr || this->bullets_environment == bullets_environment || _is_predicate_running()) {
 		return;
 	}
-	if(this->bullets_environment != nullptr) {
-		this->bullets_environment->set("current", false);
-	}
-	
+	Node* previous_environment = this->bullets_environment;
+	// Replace the environment before disabling the previous one, so that unmounting it leaves its pools to be reused.
 	this->bullets_environment = bullets_environment;
+	if(previous_environment != nullptr) {
+		previous_environment->set("current", false);
+	}
 	this->bullets_environment->set("current", true);
 
 	Array bullet_kits = bullets_environment->get("bullet_kits");
 	Array pools_sizes = bullets_environment->get("pools_sizes");
 	Array parents_paths = bullets_environment->get("parents_hints");
 	Array z_indices = bullets_environment->get("z_indices");
+	Array initial_sizes = bullets_environment->get("pools_initial_sizes");
+	Array growth_steps = bullets_environment->get("pools_growth_steps");
+	float shrink_delay = bullets_environment->get("pools_shrink_delay");
+	float mount_time_budget = bullets_environment->get("mount_time_budget");
+	pool_cache_size = bullets_environment->get("pools_cache_size");
+	int32_t areas_split = bullets_environment->get("shared_areas_split");
+	int32_t areas_chunk_size = Math::max((int32_t)bullets_environment->get("shared_areas_chunk_size"), 1);
+	mount_budget_usec = (int64_t)(mount_time_budget * 1000.0f);
+
+	int32_t threads_amount = 0;
+	if(bullets_environment->get("multithreading")) {
+		threads_amount = bullets_environment->get("threads_amount");
+		if(threads_amount <= 0) {
+			// Leave a core to the main thread, which processes pools too.
+			threads_amount = Math::max((int32_t)OS::get_singleton()->get_processor_count() - 1, 0);
+		}
+	}
+	thread_pool.start(threads_amount);
 
-	pool_sets.clear();
-	areas_to_pool_set_indices.clear();
-	kits_to_set_pool_indices.clear();
-	_clear_rids();
-	shared_areas.clear();
+	float cell_size = bullets_environment->get("collision_grid_cell_size");
+	collision_grid.set_cell_size(cell_size);
+	query_grid.set_cell_size(cell_size);
+	query_grid_dirty = true;
+	grid_enabled = false;
+	hits = Array();
+
+	// Pools of the previous environment go to the cache too, so that the new sets can reuse them.
+	_cache_pool_sets();
 
 	available_bullets = 0;
 	active_bullets = 0;
+	total_bullets = 0;
 
 	Dictionary collision_layers_masks_to_kits;
-
-	Viewport* default_viewport = bullets_environment->get_viewport();
-	RID default_parent_canvas = default_viewport->find_world_2d()->get_canvas();
 	
 	for(int32_t i = 0; i < bullet_kits.size(); i++) {
 		Ref<BulletKit> kit = bullet_kits[i];
@@ -135,8 +358,9 @@ void Bullets::mount(Node* bullets_environment) {
 		}
 		// By default add the the BulletKit to a no-collisions list. (layer and mask = 0)
 		int64_t layer_mask = 0;
-		if(kit->collisions_enabled && kit->collision_shape.is_valid()) {
+		if(kit->collisions_enabled && kit->collision_shape.is_valid() && kit->collision_backend == 0) {
 			// If collisions are enabled, add the BulletKit to another list.
+			// Kits colliding through the grid don't need a shared area.
 			layer_mask = (int64_t)kit->collision_layer + ((int64_t)kit->collision_mask << 32);
 		}
 		if(collision_layers_masks_to_kits.has(layer_mask)) {
@@ -150,90 +374,328 @@ void Bullets::mount(Node* bullets_environment) {
 	}
 	// Create the PoolKitSets array. If they exist, a set will be allocated for no-collisions pools.
 	pool_sets.resize(collision_layers_masks_to_kits.size());
+	if(pool_sets.size() > BulletID::MAX_SET + 1) {
+		ERR_PRINT("Too many different collision layers and masks, bullet handles will not be unique!");
+	}
 	
 	Array layer_mask_keys = collision_layers_masks_to_kits.keys();
 	for(int32_t i = 0; i < layer_mask_keys.size(); i++) {
 		Array kits = collision_layers_masks_to_kits[layer_mask_keys[i]];
-		Ref<BulletKit> first_kit = kits[0];
-
-		pool_sets[i].pools.resize(kits.size());
+		PoolKitSet& set = pool_sets[i];
 
-		RID shared_area = RID();
-		if(layer_mask_keys[i].operator int64_t() != 0) {
-			// This is a collisions-enabled set, create the shared area.
-			shared_area = Physics2DServer::get_singleton()->area_create();
-			Physics2DServer::get_singleton()->area_set_collision_layer(shared_area, first_kit->collision_layer);
-			Physics2DServer::get_singleton()->area_set_collision_mask(shared_area, first_kit->collision_mask);
-			Physics2DServer::get_singleton()->area_set_monitorable(shared_area, true);
-			Physics2DServer::get_singleton()->area_set_space(shared_area, get_world_2d()->get_space());
+		set.layer_mask = layer_mask_keys[i];
+		set.pools.resize(kits.size());
+		set.areas_split = set.layer_mask != 0 ? areas_split : AREAS_SPLIT_NONE;
+		set.areas_chunk_size = set.areas_split == AREAS_SPLIT_CHUNKS ? areas_chunk_size : 0;
 
-			shared_areas.append(shared_area);
-			areas_to_pool_set_indices[shared_area] = i;
-		}
 		int32_t pool_set_available_bullets = 0;
 
 		for(int32_t j = 0; j < kits.size(); j++) {
 			Ref<BulletKit> kit = kits[j];
 
-			PoolIntArray set_pool_indices = PoolIntArray();
-			set_pool_indices.resize(2);
-			set_pool_indices.set(0, i);
-			set_pool_indices.set(1, j);
-			kits_to_set_pool_indices[kit] = set_pool_indices;
+			kit->kit_slot = kit_slots.size();
+			kit_slots.push_back({ kit.ptr(), i, j });
 			
 			int32_t kit_index_in_node = bullet_kits.find(kit);
 			int32_t pool_size = pools_sizes[kit_index_in_node];
 
-			Node* parent_node_hint = nullptr;
-			//RID actual_parent_canvas = default_parent_canvas;
-
-			NodePath parent_path = parents_paths[0];//[kit_index_in_node];
-			Godot::print("Parent hint path is {0}", parent_path);
-			if (!parent_path.is_empty()) {
-				Godot::print("Parent hint path is not empty");
-				parent_node_hint = bullets_environment->get_node(parent_path);
-				Godot::print("Viewport node is {0}", parent_node_hint);
-				// if (viewport_node != nullptr) {
-				// 	actual_viewport = viewport_node;
-					// CanvasItem* parent_canvas = Object::cast_to<CanvasItem>(parent_node);
-					// if (parent_canvas != nullptr) {
-					// 	actual_parent_canvas = parent_canvas->get_canvas_item();
-					// } else {
-					// 	actual_parent_canvas = actual_viewport->find_world_2d()->get_canvas();
-					// }
-				// }
+			PoolKit& pool_kit = set.pools[j];
+			pool_kit.bullet_kit = kit;
+			pool_kit.size = pool_size;
+			pool_kit.z_index = z_indices[kit_index_in_node];
+			pool_kit.parent_hint = parents_paths[0];//[kit_index_in_node];
+
+			// A growth step of 0 keeps the pool fixed, every bullet is allocated up front.
+			pool_kit.growth_step = kit_index_in_node < growth_steps.size() ? (int32_t)growth_steps[kit_index_in_node] : 0;
+			pool_kit.initial_size = 0;
+			pool_kit.shrink_delay = 0.0f;
+			if(pool_kit.growth_step > 0) {
+				pool_kit.initial_size = kit_index_in_node < initial_sizes.size() ? (int32_t)initial_sizes[kit_index_in_node] : pool_kit.growth_step;
+				pool_kit.shrink_delay = shrink_delay;
 			}
-			if (parent_node_hint == nullptr) {
-				parent_node_hint = bullets_environment;
+
+			if(kit->collisions_enabled && kit->collision_shape.is_valid() && kit->collision_backend == 1) {
+				grid_enabled = true;
+			}
+			set.shapes_to_pools.resize(pool_set_available_bullets + pool_size, j);
+			pool_set_available_bullets += pool_size;
+		}
+		if(pool_set_available_bullets > BulletID::MAX_INDEX + 1) {
+			ERR_PRINT("Too many bullets share the same collision layer and mask, their handles will not be unique!");
+		}
+		set.bullets_amount = pool_set_available_bullets;
+
+		if(!_reuse_pool_set(i)) {
+			_create_shared_areas(set, kits[0]);
+			int32_t starting_shape_index = 0;
+			for(int32_t j = 0; j < set.pools.size(); j++) {
+				// A cached pool is moved to the new area when its turn comes, otherwise a new one is created.
+				set.pools[j].pool = _take_cached_pool(set.pools[j], set.layer_mask);
+				pending_pools.push_back({ i, j, starting_shape_index });
+				starting_shape_index += set.pools[j].size;
 			}
+		}
+		for(int32_t j = 0; j < set.shared_areas.size(); j++) {
+			areas_to_pool_set_indices[set.shared_areas[j].get_id()] = { i, set.areas_first_shapes[j] };
+		}
+	}
+	_prune_pool_cache();
 
-			pool_sets[i].pools[j].pool = kit->_create_pool();
-			pool_sets[i].pools[j].bullet_kit = kit;
-			pool_sets[i].pools[j].size = pool_size;
-			pool_sets[i].pools[j].z_index = z_indices[kit_index_in_node];
+	mounting = true;
+	_mount_pending_pools();
+}
 
-			pool_sets[i].pools[j].pool->_init(/*actual_parent_canvas, */parent_node_hint, shared_area, pool_set_available_bullets,
-				i, kit, pool_size, z_indices[kit_index_in_node]);
+bool Bullets::_is_pool_reusable(const PoolKit& pool_kit, const PoolKit& cached_pool_kit) {
+	// The same kit could have been edited since the pool has been created.
+	return cached_pool_kit.pool && pool_kit.bullet_kit == cached_pool_kit.bullet_kit && pool_kit.z_index == cached_pool_kit.z_index &&
+		pool_kit.initial_size == cached_pool_kit.initial_size && pool_kit.growth_step == cached_pool_kit.growth_step &&
+		pool_kit.shrink_delay == cached_pool_kit.shrink_delay &&
+		cached_pool_kit.pool->_is_reusable(pool_kit.bullet_kit, _get_parent_hint(pool_kit.parent_hint));
+}
 
-			pool_set_available_bullets += pool_size;
+bool Bullets::_reuse_pool_set(int32_t set_index) {
+	PoolKitSet& set = pool_sets[set_index];
+
+	// Prefer the most recently cached sets.
+	for(int32_t i = cached_sets.size() - 1; i >= 0; i--) {
+		PoolKitSet& cached_set = cached_sets[i];
+		if(cached_set.layer_mask != set.layer_mask || cached_set.pools.size() != set.pools.size() ||
+				cached_set.ready_pools != cached_set.pools.size() ||
+				cached_set.areas_split != set.areas_split || cached_set.areas_chunk_size != set.areas_chunk_size) {
+			continue;
+		}
+		// Pools own consecutive shape ranges of the shared area, they can only be reused all together and in the same order.
+		bool compatible = true;
+		for(int32_t j = 0; j < set.pools.size() && compatible; j++) {
+			compatible = set.pools[j].size == cached_set.pools[j].size && _is_pool_reusable(set.pools[j], cached_set.pools[j]);
+		}
+		if(!compatible) {
+			continue;
+		}
+		for(int32_t j = 0; j < set.pools.size(); j++) {
+			set.pools[j].pool = std::move(cached_set.pools[j].pool);
+			set.pools[j].pool->_set_parent_hint(_get_parent_hint(set.pools[j].parent_hint));
+			set.pools[j].pool->set_index = set_index;
+		}
+		set.shared_areas = std::move(cached_set.shared_areas);
+		set.areas_first_shapes = std::move(cached_set.areas_first_shapes);
+		set.ready_pools = set.pools.size();
+		available_bullets += set.bullets_amount;
+		total_bullets += set.bullets_amount;
+
+		cached_sets.erase(cached_sets.begin() + i);
+		return true;
+	}
+	return false;
+}
+
+std::unique_ptr<BulletsPool> Bullets::_take_cached_pool(const PoolKit& pool_kit, int64_t layer_mask) {
+	for(int32_t i = cached_sets.size() - 1; i >= 0; i--) {
+		PoolKitSet& cached_set = cached_sets[i];
+		if(cached_set.layer_mask != layer_mask) {
+			continue;
+		}
+		for(int32_t j = 0; j < cached_set.pools.size(); j++) {
+			// The pool size can differ, it's changed when the pool is moved to its new set.
+			if(_is_pool_reusable(pool_kit, cached_set.pools[j])) {
+				cached_set.pools[j].pool->_set_parent_hint(_get_parent_hint(pool_kit.parent_hint));
+				return std::move(cached_set.pools[j].pool);
+			}
+		}
+	}
+	return nullptr;
+}
+
+void Bullets::_cache_pool_sets() {
+	_clear_kit_slots();
+	for(int32_t i = 0; i < pool_sets.size(); i++) {
+		PoolKitSet& set = pool_sets[i];
+		// Bullets don't survive the environment they have been spawned in, their IDs are invalidated too.
+		for(int32_t j = 0; j < set.ready_pools; j++) {
+			set.pools[j].pool->release_all();
+			// The set can be reused as a whole, its shapes must be disabled already.
+			set.pools[j].pool->_flush_shape_changes();
+		}
+		cached_sets.push_back(std::move(set));
+	}
+	pool_sets.clear();
+	areas_to_pool_set_indices.clear();
+	pending_pools.clear();
+	next_pending_pool = 0;
+	mounting = false;
+}
+
+void Bullets::_prune_pool_cache() {
+	// Pools drawn on a freed canvas, like the one of a CanvasLayer of the previous scene, can't be reused.
+	for(int32_t i = 0; i < cached_sets.size(); i++) {
+		for(int32_t j = 0; j < cached_sets[i].pools.size(); j++) {
+			if(cached_sets[i].pools[j].pool && !cached_sets[i].pools[j].pool->_is_canvas_valid()) {
+				cached_sets[i].pools[j].pool.reset();
+			}
+		}
+	}
+	int32_t cached_bullets = 0;
+	// Keep the most recently cached sets that fit, sets without pools left are freed.
+	for(int32_t i = cached_sets.size() - 1; i >= 0; i--) {
+		int32_t set_bullets = 0;
+		for(int32_t j = 0; j < cached_sets[i].pools.size(); j++) {
+			if(cached_sets[i].pools[j].pool) {
+				set_bullets += cached_sets[i].pools[j].pool->pool_size;
+			}
+		}
+		if(set_bullets == 0 || cached_bullets + set_bullets > pool_cache_size) {
+			_free_pool_set(cached_sets[i]);
+			cached_sets.erase(cached_sets.begin() + i);
+		} else {
+			cached_bullets += set_bullets;
+		}
+	}
+}
+
+void Bullets::clear_pool_cache() {
+	for(int32_t i = 0; i < cached_sets.size(); i++) {
+		_free_pool_set(cached_sets[i]);
+	}
+	cached_sets.clear();
+}
+
+Node* Bullets::_get_parent_hint(NodePath parent_path) {
+	Node* parent_node_hint = nullptr;
+	if (!parent_path.is_empty()) {
+		parent_node_hint = bullets_environment->get_node(parent_path);
+	}
+	if (parent_node_hint == nullptr) {
+		parent_node_hint = bullets_environment;
+	}
+	return parent_node_hint;
+}
+
+void Bullets::_create_shared_areas(PoolKitSet& set, const Ref<BulletKit>& first_kit) {
+	if(set.layer_mask == 0) {
+		// Kits without collisions don't need an area.
+		return;
+	}
+	if(set.areas_split == AREAS_SPLIT_PER_POOL) {
+		int32_t first_shape = 0;
+		for(int32_t i = 0; i < set.pools.size(); i++) {
+			set.areas_first_shapes.push_back(first_shape);
+			first_shape += set.pools[i].size;
+		}
+	} else if(set.areas_split == AREAS_SPLIT_CHUNKS) {
+		for(int32_t first_shape = 0; first_shape < set.bullets_amount; first_shape += set.areas_chunk_size) {
+			set.areas_first_shapes.push_back(first_shape);
+		}
+	} else {
+		set.areas_first_shapes.push_back(0);
+	}
+
+	for(int32_t i = 0; i < set.areas_first_shapes.size(); i++) {
+		RID area = Physics2DServer::get_singleton()->area_create();
+		Physics2DServer::get_singleton()->area_set_collision_layer(area, first_kit->collision_layer);
+		Physics2DServer::get_singleton()->area_set_collision_mask(area, first_kit->collision_mask);
+		Physics2DServer::get_singleton()->area_set_monitorable(area, true);
+		Physics2DServer::get_singleton()->area_set_space(area, get_world_2d()->get_space());
+		set.shared_areas.push_back(area);
+	}
+}
+
+BulletsPoolAreas Bullets::_get_pool_areas(const PoolKitSet& set, int32_t starting_shape_index, int32_t pool_size) {
+	BulletsPoolAreas pool_areas;
+	// Areas are sorted by their first shape, take the ones holding a part of the shape range of the pool.
+	for(int32_t i = 0; i < set.shared_areas.size(); i++) {
+		int32_t area_end = i + 1 < set.areas_first_shapes.size() ? set.areas_first_shapes[i + 1] : set.bullets_amount;
+		if(set.areas_first_shapes[i] < starting_shape_index + pool_size && area_end > starting_shape_index) {
+			if(pool_areas.areas.empty()) {
+				pool_areas.first_shape_index = set.areas_first_shapes[i];
+			}
+			pool_areas.areas.push_back(set.shared_areas[i]);
+		}
+	}
+	if(set.areas_split == AREAS_SPLIT_PER_POOL) {
+		pool_areas.shapes_per_area = Math::max(pool_size, 1);
+	} else if(set.areas_split == AREAS_SPLIT_CHUNKS) {
+		pool_areas.shapes_per_area = set.areas_chunk_size;
+	} else {
+		pool_areas.shapes_per_area = INT32_MAX;
+	}
+	return pool_areas;
+}
+
+void Bullets::_mount_pending_pools() {
+	auto start = std::chrono::steady_clock::now();
+	int32_t first_pending_pool = next_pending_pool;
+
+	while(next_pending_pool < pending_pools.size()) {
+		// Initialize at least one pool each frame, even if it alone takes longer than the budget.
+		if(mount_budget_usec > 0 && next_pending_pool > first_pending_pool &&
+				std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() >= mount_budget_usec) {
+			return;
+		}
+		const PendingPool& pending = pending_pools[next_pending_pool];
+		PoolKitSet& set = pool_sets[pending.set_index];
+		PoolKit& pool_kit = set.pools[pending.pool_index];
+
+		if(pool_kit.pool) {
+			// Taken from the cache, its parent hint has already been updated.
+			pool_kit.pool->_rebind(_get_pool_areas(set, pending.starting_shape_index, pool_kit.size),
+				pending.starting_shape_index, pending.set_index, pool_kit.size);
+		} else {
+			pool_kit.pool = pool_kit.bullet_kit->_create_pool();
+			if(pool_kit.growth_step > 0) {
+				pool_kit.pool->_set_elastic(pool_kit.initial_size, pool_kit.growth_step, pool_kit.shrink_delay);
+			}
+			pool_kit.pool->_init(/*actual_parent_canvas, */_get_parent_hint(pool_kit.parent_hint),
+				_get_pool_areas(set, pending.starting_shape_index, pool_kit.size), pending.starting_shape_index,
+				pending.set_index, pool_kit.bullet_kit, pool_kit.size, pool_kit.z_index);
 		}
-		pool_sets[i].bullets_amount = pool_set_available_bullets;
-		available_bullets += pool_set_available_bullets;
+
+		// Pools of a set are initialized in order, the new one is the last ready.
+		set.ready_pools = pending.pool_index + 1;
+		available_bullets += pool_kit.size;
+		total_bullets += pool_kit.size;
+		next_pending_pool++;
+	}
+	pending_pools.clear();
+	next_pending_pool = 0;
+	mounting = false;
+	emit_signal("mounted", bullets_environment);
+}
+
+void Bullets::_free_pool_set(PoolKitSet& set) {
+	// Pools don't touch the shared areas when freed, Bullets is responsible for their shapes.
+	set.pools.clear();
+	set.ready_pools = 0;
+	for(int32_t i = 0; i < set.shared_areas.size(); i++) {
+		Physics2DServer::get_singleton()->area_clear_shapes(set.shared_areas[i]);
+		Physics2DServer::get_singleton()->free_rid(set.shared_areas[i]);
 	}
-	total_bullets = available_bullets;
+	set.shared_areas.clear();
+	set.areas_first_shapes.clear();
+}
+
+void Bullets::_clear_pool_sets() {
+	for(int32_t i = 0; i < pool_sets.size(); i++) {
+		_free_pool_set(pool_sets[i]);
+	}
+	pool_sets.clear();
+	clear_pool_cache();
 }
 
 void Bullets::unmount(Node* bullets_environment) {
+	if(_is_predicate_running()) {
+		return;
+	}
 	if(this->bullets_environment == bullets_environment) {
-		pool_sets.clear();
-		areas_to_pool_set_indices.clear();
-		kits_to_set_pool_indices.clear();
-		_clear_rids();
-		shared_areas.clear();
+		// Pools are kept up to the cache size of the environment, for the next mount to reuse them.
+		_cache_pool_sets();
+		_prune_pool_cache();
 
 		available_bullets = 0;
 		active_bullets = 0;
 		total_bullets = 0;
+		thread_pool.stop();
+		grid_enabled = false;
+		hits = Array();
 
 		this->bullets_environment = nullptr;
 	}
@@ -246,49 +708,102 @@ Node* Bullets::get_bullets_environment() {
 	return bullets_environment;
 }
 
+bool Bullets::is_mounting() {
+	return mounting;
+}
+
 bool Bullets::spawn_bullet(Ref<BulletKit> kit, Dictionary properties) {
-	if(available_bullets > 0 && kits_to_set_pool_indices.has(kit)) {
-		PoolIntArray set_pool_indices = kits_to_set_pool_indices[kit].operator PoolIntArray();
-		BulletsPool* pool = pool_sets[set_pool_indices[0]].pools[set_pool_indices[1]].pool.get();
+	if(_is_predicate_running()) {
+		return false;
+	}
+	PoolKit* pool_kit = _get_pool_kit(kit);
+	if(available_bullets > 0 && pool_kit != nullptr) {
+		BulletsPool* pool = pool_kit->pool.get();
 
 		if(pool->get_available_bullets() > 0) {
 			available_bullets -= 1;
 			active_bullets += 1;
 
 			pool->spawn_bullet(properties);
+			query_grid_dirty = true;
 			return true;
 		}
 	}
 	return false;
 }
 
+int32_t Bullets::spawn_bullets(Ref<BulletKit> kit, PoolVector2Array positions, PoolVector2Array velocities, PoolRealArray rotations) {
+	int32_t amount = positions.size();
+	if((velocities.size() != 0 && velocities.size() < amount) || (rotations.size() != 0 && rotations.size() < amount)) {
+		ERR_PRINT("Velocities and rotations must be empty or contain a value for each position!");
+		return 0;
+	}
+	PoolVector2Array::Read positions_read = positions.read();
+	PoolVector2Array::Read velocities_read = velocities.read();
+	PoolRealArray::Read rotations_read = rotations.read();
+
+	return _spawn_bullets(kit, positions_read.ptr(),
+		velocities.size() > 0 ? velocities_read.ptr() : nullptr,
+		rotations.size() > 0 ? rotations_read.ptr() : nullptr, amount);
+}
+
+int32_t Bullets::_spawn_bullets(const Ref<BulletKit>& kit, const Vector2* positions, const Vector2* velocities,
+		const real_t* rotations, int32_t amount) {
+	if(_is_predicate_running()) {
+		return 0;
+	}
+	PoolKit* pool_kit = _get_pool_kit(kit);
+	if(amount > 0 && available_bullets > 0 && pool_kit != nullptr) {
+		int32_t spawned = pool_kit->pool->spawn_bullets(positions, velocities, rotations, amount);
+		available_bullets -= spawned;
+		active_bullets += spawned;
+		query_grid_dirty = true;
+		return spawned;
+	}
+	return 0;
+}
+
 Variant Bullets::obtain_bullet(Ref<BulletKit> kit) {
-	if(available_bullets > 0 && kits_to_set_pool_indices.has(kit)) {
-		PoolIntArray set_pool_indices = kits_to_set_pool_indices[kit].operator PoolIntArray();
-		BulletsPool* pool = pool_sets[set_pool_indices[0]].pools[set_pool_indices[1]].pool.get();
+	BulletID bullet_id = _obtain_bullet(kit);
+	if(bullet_id.index < 0) {
+		return invalid_id;
+	}
+	return _to_pool_int_array(bullet_id);
+}
+
+int64_t Bullets::obtain_bullet_handle(Ref<BulletKit> kit) {
+	return _obtain_bullet(kit).to_handle();
+}
+
+BulletID Bullets::_obtain_bullet(Ref<BulletKit> kit) {
+	if(_is_predicate_running()) {
+		return BulletID(-1, -1, -1);
+	}
+	PoolKit* pool_kit = _get_pool_kit(kit);
+	if(available_bullets > 0 && pool_kit != nullptr) {
+		BulletsPool* pool = pool_kit->pool.get();
 
 		if(pool->get_available_bullets() > 0) {
 			available_bullets -= 1;
 			active_bullets += 1;
 
-			BulletID bullet_id = pool->obtain_bullet();
-			PoolIntArray to_return = invalid_id;
-			to_return.set(0, bullet_id.index);
-			to_return.set(1, bullet_id.cycle);
-			to_return.set(2, bullet_id.set);
-			return to_return;
+			query_grid_dirty = true;
+			return pool->obtain_bullet();
 		}
 	}
-	return invalid_id;
+	return BulletID(-1, -1, -1);
 }
 
 bool Bullets::release_bullet(Variant id) {
-	PoolIntArray bullet_id = id.operator PoolIntArray();
+	if(_is_predicate_running()) {
+		return false;
+	}
+	BulletID bullet_id = _to_bullet_id(id);
 	bool result = false;
 
-	int32_t pool_index = _get_pool_index(bullet_id[2], bullet_id[0]);
+	int32_t pool_index = _get_pool_index(bullet_id.set, bullet_id.index);
 	if(pool_index >= 0) {
-		result = pool_sets[bullet_id[2]].pools[pool_index].pool->release_bullet(BulletID(bullet_id[0], bullet_id[1], bullet_id[2]));
+		result = pool_sets[bullet_id.set].pools[pool_index].pool->release_bullet(bullet_id);
 		if(result) {
 			available_bullets += 1;
 			active_bullets -= 1;
@@ -297,48 +812,161 @@ bool Bullets::release_bullet(Variant id) {
 	return result;
 }
 
+bool Bullets::_is_predicate_running() {
+	if(predicate_running) {
+		ERR_PRINT("Bullets can't be spawned or released by the predicate of release_by_predicate!");
+	}
+	return predicate_running;
+}
+
+int32_t Bullets::release_all() {
+	if(_is_predicate_running()) {
+		return 0;
+	}
+	int32_t released = 0;
+	for(int32_t i = 0; i < pool_sets.size(); i++) {
+		for(int32_t j = 0; j < pool_sets[i].ready_pools; j++) {
+			released += pool_sets[i].pools[j].pool->release_all();
+		}
+	}
+	available_bullets += released;
+	active_bullets -= released;
+	return released;
+}
+
+int32_t Bullets::release_kit(Ref<BulletKit> kit) {
+	if(_is_predicate_running()) {
+		return 0;
+	}
+	PoolKit* pool_kit = _get_pool_kit(kit);
+	if(pool_kit == nullptr) {
+		return 0;
+	}
+	int32_t released = pool_kit->pool->release_all();
+	available_bullets += released;
+	active_bullets -= released;
+	return released;
+}
+
+int32_t Bullets::_release_in_shape(const BulletsGridShape& shape, const Transform2D& transform, const Ref<BulletKit>& kit,
+		int32_t collision_layer) {
+	if(_is_predicate_running()) {
+		return 0;
+	}
+	// Each pool tests its own bullets in a single pass, the query grid is not needed.
+	int32_t released = 0;
+	for(int32_t i = 0; i < pool_sets.size(); i++) {
+		for(int32_t j = 0; j < pool_sets[i].ready_pools; j++) {
+			PoolKit& pool_kit = pool_sets[i].pools[j];
+			if((kit.is_null() || pool_kit.bullet_kit == kit) &&
+					(collision_layer == 0 || (pool_kit.bullet_kit->collision_layer & collision_layer) != 0)) {
+				released += pool_kit.pool->release_in_shape(shape, transform);
+			}
+		}
+	}
+	available_bullets += released;
+	active_bullets -= released;
+	return released;
+}
+
+int32_t Bullets::release_in_rect(Rect2 rect, Ref<BulletKit> kit, int32_t collision_layer) {
+	BulletsGridShape shape;
+	shape.circle = false;
+	shape.extents = rect.size.abs() / 2.0f;
+	return _release_in_shape(shape, Transform2D(0.0f, rect.position + rect.size / 2.0f), kit, collision_layer);
+}
+
+int32_t Bullets::release_in_circle(Vector2 center, float radius, Ref<BulletKit> kit, int32_t collision_layer) {
+	BulletsGridShape shape;
+	shape.circle = true;
+	shape.radius = Math::max(radius, 0.0f);
+	return _release_in_shape(shape, Transform2D(0.0f, center), kit, collision_layer);
+}
+
+int32_t Bullets::release_older_than(Ref<BulletKit> kit, float lifetime) {
+	if(_is_predicate_running()) {
+		return 0;
+	}
+	int32_t released = 0;
+	for(int32_t i = 0; i < pool_sets.size(); i++) {
+		for(int32_t j = 0; j < pool_sets[i].ready_pools; j++) {
+			PoolKit& pool_kit = pool_sets[i].pools[j];
+			if(kit.is_null() || pool_kit.bullet_kit == kit) {
+				released += pool_kit.pool->release_older_than(lifetime);
+			}
+		}
+	}
+	available_bullets += released;
+	active_bullets -= released;
+	return released;
+}
+
+int32_t Bullets::release_by_predicate(Ref<BulletKit> kit, Object* target, String method) {
+	if(target == nullptr) {
+		ERR_PRINT("release_by_predicate needs a target object!");
+		return 0;
+	}
+	if(_is_predicate_running()) {
+		return 0;
+	}
+	int32_t released = 0;
+	predicate_running = true;
+	for(int32_t i = 0; i < pool_sets.size(); i++) {
+		for(int32_t j = 0; j < pool_sets[i].ready_pools; j++) {
+			PoolKit& pool_kit = pool_sets[i].pools[j];
+			if(kit.is_null() || pool_kit.bullet_kit == kit) {
+				released += pool_kit.pool->release_by_predicate(target, method);
+			}
+		}
+	}
+	predicate_running = false;
+	available_bullets += released;
+	active_bullets -= released;
+	return released;
+}
+
 bool Bullets::is_bullet_valid(Variant id) {
-	PoolIntArray bullet_id = id.operator PoolIntArray();
+	BulletID bullet_id = _to_bullet_id(id);
 
-	int32_t pool_index = _get_pool_index(bullet_id[2], bullet_id[0]);
+	int32_t pool_index = _get_pool_index(bullet_id.set, bullet_id.index);
 	if(pool_index >= 0) {
-		return pool_sets[bullet_id[2]].pools[pool_index].pool->is_bullet_valid(BulletID(bullet_id[0], bullet_id[1], bullet_id[2]));
+		return pool_sets[bullet_id.set].pools[pool_index].pool->is_bullet_valid(bullet_id);
 	}
 	return false;
 }
 
 bool Bullets::is_kit_valid(Ref<BulletKit> kit) {
-	return kits_to_set_pool_indices.has(kit);
+	return _get_pool_kit(kit) != nullptr;
 }
 
 int32_t Bullets::get_available_bullets(Ref<BulletKit> kit) {
-	if(kits_to_set_pool_indices.has(kit)) {
-		PoolIntArray set_pool_indices = kits_to_set_pool_indices[kit];
-		return pool_sets[set_pool_indices[0]].pools[set_pool_indices[1]].pool->get_available_bullets();
+	PoolKit* pool_kit = _get_pool_kit(kit);
+	if(pool_kit != nullptr) {
+		return pool_kit->pool->get_available_bullets();
 	}
 	return 0;
 }
 
 int32_t Bullets::get_active_bullets(Ref<BulletKit> kit) {
-	if(kits_to_set_pool_indices.has(kit)) {
-		PoolIntArray set_pool_indices = kits_to_set_pool_indices[kit];
-		return pool_sets[set_pool_indices[0]].pools[set_pool_indices[1]].pool->get_active_bullets();
+	PoolKit* pool_kit = _get_pool_kit(kit);
+	if(pool_kit != nullptr) {
+		return pool_kit->pool->get_active_bullets();
 	}
 	return 0;
 }
 
 int32_t Bullets::get_pool_size(Ref<BulletKit> kit) {
-	if(kits_to_set_pool_indices.has(kit)) {
-		PoolIntArray set_pool_indices = kits_to_set_pool_indices[kit];
-		return pool_sets[set_pool_indices[0]].pools[set_pool_indices[1]].size;
+	PoolKit* pool_kit = _get_pool_kit(kit);
+	if(pool_kit != nullptr) {
+		return pool_kit->size;
 	}
 	return 0;
 }
 
 int32_t Bullets::get_z_index(Ref<BulletKit> kit) {
-	if(kits_to_set_pool_indices.has(kit)) {
-		PoolIntArray set_pool_indices = kits_to_set_pool_indices[kit];
-		return pool_sets[set_pool_indices[0]].pools[set_pool_indices[1]].z_index;
+	PoolKit* pool_kit = _get_pool_kit(kit);
+	if(pool_kit != nullptr) {
+		return pool_kit->z_index;
 	}
 	return 0;
 }
@@ -351,11 +979,31 @@ int32_t Bullets::get_total_active_bullets() {
 	return active_bullets;
 }
 
-bool Bullets::is_bullet_existing(RID area_rid, int32_t shape_index) {
-	if(!areas_to_pool_set_indices.has(area_rid)) {
-		return false;
+Dictionary Bullets::get_frame_stats() {
+	Dictionary frame_stats;
+	for(int32_t i = 0; i < pool_sets.size(); i++) {
+		for(int32_t j = 0; j < pool_sets[i].ready_pools; j++) {
+			BulletsPool* pool = pool_sets[i].pools[j].pool.get();
+			const BulletsPoolStats& stats = pool->get_frame_stats();
+
+			Dictionary kit_stats;
+			kit_stats["simulation_usec"] = stats.simulation_usec;
+			kit_stats["commit_usec"] = stats.commit_usec;
+			kit_stats["server_calls"] = stats.server_calls;
+			kit_stats["spawns"] = stats.spawns;
+			kit_stats["releases"] = stats.releases;
+			kit_stats["deaths"] = stats.deaths;
+			kit_stats["active_bullets"] = pool->get_active_bullets();
+			kit_stats["high_water_mark"] = pool->get_high_water_mark();
+			kit_stats["allocated_bullets"] = pool->get_allocated_bullets();
+			frame_stats[pool_sets[i].pools[j].bullet_kit] = kit_stats;
+		}
 	}
-	int32_t set_index = areas_to_pool_set_indices[area_rid];
+	return frame_stats;
+}
+
+bool Bullets::is_bullet_existing(RID area_rid, int32_t shape_index) {
+	int32_t set_index = _get_pool_set_index(area_rid, shape_index);
 	int32_t pool_index = _get_pool_index(set_index, shape_index);
 	if(pool_index >= 0) {
 		return pool_sets[set_index].pools[pool_index].pool->is_bullet_existing(shape_index);
@@ -364,48 +1012,180 @@ bool Bullets::is_bullet_existing(RID area_rid, int32_t shape_index) {
 }
 
 Variant Bullets::get_bullet_from_shape(RID area_rid, int32_t shape_index) {
-	if(!areas_to_pool_set_indices.has(area_rid)) {
+	BulletID bullet_id = _get_bullet_from_shape(area_rid, shape_index);
+	if(bullet_id.index < 0) {
 		return invalid_id;
 	}
-	int32_t set_index = areas_to_pool_set_indices[area_rid];
+	return _to_pool_int_array(bullet_id);
+}
+
+int64_t Bullets::get_bullet_handle_from_shape(RID area_rid, int32_t shape_index) {
+	return _get_bullet_from_shape(area_rid, shape_index).to_handle();
+}
+
+BulletID Bullets::_get_bullet_from_shape(RID area_rid, int32_t shape_index) {
+	int32_t set_index = _get_pool_set_index(area_rid, shape_index);
 	int32_t pool_index = _get_pool_index(set_index, shape_index);
 	if(pool_index >= 0) {
-		BulletID result = pool_sets[set_index].pools[pool_index].pool->get_bullet_from_shape(shape_index);
-
-		PoolIntArray to_return = invalid_id;
-		to_return.set(0, result.index);
-		to_return.set(1, result.cycle);
-		to_return.set(2, result.set);
-		return to_return;
+		return pool_sets[set_index].pools[pool_index].pool->get_bullet_from_shape(shape_index);
 	}
-	return invalid_id;
+	return BulletID(-1, -1, -1);
 }
 
 Ref<BulletKit> Bullets::get_kit_from_bullet(Variant id) {
-	PoolIntArray bullet_id = id.operator PoolIntArray();
+	BulletID bullet_id = _to_bullet_id(id);
 
-	int32_t pool_index = _get_pool_index(bullet_id[2], bullet_id[0]);
-	if(pool_index >= 0 && pool_sets[bullet_id[2]].pools[pool_index].pool->is_bullet_valid(BulletID(bullet_id[0], bullet_id[1], bullet_id[2]))) {
-		return pool_sets[bullet_id[2]].pools[pool_index].bullet_kit;
+	int32_t pool_index = _get_pool_index(bullet_id.set, bullet_id.index);
+	if(pool_index >= 0 && pool_sets[bullet_id.set].pools[pool_index].pool->is_bullet_valid(bullet_id)) {
+		return pool_sets[bullet_id.set].pools[pool_index].bullet_kit;
 	}
 	return Ref<BulletKit>();
 }
 
 void Bullets::set_bullet_property(Variant id, String property, Variant value) {
-	PoolIntArray bullet_id = id.operator PoolIntArray();
+	BulletID bullet_id = _to_bullet_id(id);
 
-	int32_t pool_index = _get_pool_index(bullet_id[2], bullet_id[0]);
+	int32_t pool_index = _get_pool_index(bullet_id.set, bullet_id.index);
 	if(pool_index >= 0) {
-		pool_sets[bullet_id[2]].pools[pool_index].pool->set_bullet_property(BulletID(bullet_id[0], bullet_id[1], bullet_id[2]), property, value);
+		pool_sets[bullet_id.set].pools[pool_index].pool->set_bullet_property(bullet_id, property, value);
+		query_grid_dirty = true;
 	}
 }
 
 Variant Bullets::get_bullet_property(Variant id, String property) {
-	PoolIntArray bullet_id = id.operator PoolIntArray();
+	BulletID bullet_id = _to_bullet_id(id);
 
-	int32_t pool_index = _get_pool_index(bullet_id[2], bullet_id[0]);
+	int32_t pool_index = _get_pool_index(bullet_id.set, bullet_id.index);
 	if(pool_index >= 0) {
-		return pool_sets[bullet_id[2]].pools[pool_index].pool->get_bullet_property(BulletID(bullet_id[0], bullet_id[1], bullet_id[2]), property);
+		return pool_sets[bullet_id.set].pools[pool_index].pool->get_bullet_property(bullet_id, property);
 	}
 	return Variant();
+}
+
+int64_t Bullets::schedule_event(Object* target, String method, float delay, float interval) {
+	if(target == nullptr) {
+		ERR_PRINT("Events need a target!");
+		return 0;
+	}
+	return scheduler.schedule(target, method, delay, interval);
+}
+
+bool Bullets::cancel_event(int64_t event_id) {
+	return scheduler.cancel(event_id);
+}
+
+bool Bullets::set_event_interval(int64_t event_id, float interval) {
+	return scheduler.set_interval(event_id, interval);
+}
+
+bool Bullets::is_event_scheduled(int64_t event_id) {
+	return scheduler.is_scheduled(event_id);
+}
+
+void Bullets::_update_query_grid() {
+	query_grid.clear();
+	for(int32_t i = 0; i < pool_sets.size(); i++) {
+		for(int32_t j = 0; j < pool_sets[i].ready_pools; j++) {
+			pool_sets[i].pools[j].pool->_add_to_query_grid(query_grid);
+		}
+	}
+	query_grid.build();
+	query_grid_dirty = false;
+}
+
+void Bullets::_query_bullets(const BulletsGridShape& shape, const Transform2D& transform, const Ref<BulletKit>& kit,
+		int32_t collision_layer, std::vector<BulletID>& result) {
+	if(query_grid_dirty) {
+		_update_query_grid();
+	}
+	query_hits.clear();
+	query_grid.query(shape, transform, UINT32_MAX, query_hits);
+
+	for(int32_t i = 0; i < query_hits.size(); i++) {
+		const BulletID& bullet_id = query_hits[i];
+		int32_t pool_index = _get_pool_index(bullet_id.set, bullet_id.index);
+		if(pool_index < 0) {
+			continue;
+		}
+		const PoolKit& pool_kit = pool_sets[bullet_id.set].pools[pool_index];
+		if((kit.is_valid() && pool_kit.bullet_kit != kit) ||
+				(collision_layer != 0 && (pool_kit.bullet_kit->collision_layer & collision_layer) == 0)) {
+			continue;
+		}
+		// Releases don't rebuild the grid, skip the bullets released since then.
+		if(pool_kit.pool->is_bullet_valid(bullet_id)) {
+			result.push_back(bullet_id);
+		}
+	}
+}
+
+Array Bullets::_query(const BulletsGridShape& shape, const Transform2D& transform, const Ref<BulletKit>& kit, int32_t collision_layer) {
+	std::vector<BulletID> result;
+	_query_bullets(shape, transform, kit, collision_layer, result);
+
+	Array handles;
+	for(int32_t i = 0; i < result.size(); i++) {
+		handles.append(result[i].to_handle());
+	}
+	return handles;
+}
+
+Array Bullets::query_circle(Vector2 center, float radius, Ref<BulletKit> kit, int32_t collision_layer) {
+	BulletsGridShape shape;
+	shape.circle = true;
+	shape.radius = Math::max(radius, 0.0f);
+	return _query(shape, Transform2D(0.0f, center), kit, collision_layer);
+}
+
+Array Bullets::query_rect(Rect2 rect, Ref<BulletKit> kit, int32_t collision_layer) {
+	BulletsGridShape shape;
+	shape.circle = false;
+	shape.extents = rect.size.abs() / 2.0f;
+	return _query(shape, Transform2D(0.0f, rect.position + rect.size / 2.0f), kit, collision_layer);
+}
+
+Array Bullets::query_segment(Vector2 from, Vector2 to, Ref<BulletKit> kit, int32_t collision_layer) {
+	// A rectangle without height, aligned with the segment.
+	BulletsGridShape shape;
+	shape.circle = false;
+	shape.extents = Vector2((to - from).length() / 2.0f, 0.0f);
+	return _query(shape, Transform2D((to - from).angle(), (from + to) / 2.0f), kit, collision_layer);
+}
+
+void Bullets::add_hurtbox(Node2D* node, Ref<Shape2D> shape, int32_t collision_mask) {
+	if(node == nullptr) {
+		return;
+	}
+	BulletsGridShape grid_shape;
+	if(shape.is_null() || !grid_shape.set_from(shape)) {
+		ERR_PRINT("Hurtboxes only support CircleShape2D and RectangleShape2D!");
+		return;
+	}
+	int64_t instance_id = node->get_instance_id();
+	for(int32_t i = 0; i < hurtboxes.size(); i++) {
+		if(hurtboxes[i].instance_id == instance_id) {
+			hurtboxes[i].shape = grid_shape;
+			hurtboxes[i].collision_mask = collision_mask;
+			return;
+		}
+	}
+	hurtboxes.push_back({ instance_id, grid_shape, (uint32_t)collision_mask });
+}
+
+void Bullets::remove_hurtbox(Node2D* node) {
+	if(node == nullptr) {
+		return;
+	}
+	int64_t instance_id = node->get_instance_id();
+	for(int32_t i = 0; i < hurtboxes.size(); i++) {
+		if(hurtboxes[i].instance_id == instance_id) {
+			hurtboxes[i] = hurtboxes.back();
+			hurtboxes.pop_back();
+			return;
+		}
+	}
+}
+
+Array Bullets::get_hits() {
+	return hits;
 }
\ No newline at end of file
@@ -11,9 +11,13 @@
 
 #include <vector>
 #include <memory>
+#include <unordered_map>
 
 #include "bullet_kit.h"
 #include "bullets_pool.h"
+#include "bullets_thread_pool.h"
+#include "bullets_grid.h"
+#include "bullets_scheduler.h"
 
 using namespace godot;
 
@@ -22,35 +26,150 @@ class Bullets : public Node2D {
 	GODOT_CLASS(Bullets, Node2D)
 	
 private:
+	// Ways the shapes of a set can be split between areas, so that a single area doesn't hold all of them.
+	enum AreasSplit {
+		AREAS_SPLIT_NONE = 0,
+		AREAS_SPLIT_PER_POOL = 1,
+		AREAS_SPLIT_CHUNKS = 2
+	};
+
 	// A pool internal representation with related properties.
 	struct PoolKit {
 		std::unique_ptr<BulletsPool> pool;
 		Ref<BulletKit> bullet_kit;
 		int32_t size;
 		int32_t z_index;
+		// Configuration the pool has been created with, compared when another environment could reuse it.
+		NodePath parent_hint;
+		int32_t initial_size;
+		int32_t growth_step;
+		float shrink_delay;
 	};
 	struct PoolKitSet {
 		std::vector<PoolKit> pools;
+		// Maps each shape index of the set to the index of the pool owning it.
+		std::vector<int32_t> shapes_to_pools;
 		int32_t bullets_amount;
+		// Collision layer and mask of the kits, 0 for the set of the kits without shared areas.
+		int64_t layer_mask = 0;
+		// Areas holding the shapes of the set, each one starting from the matching shape index.
+		std::vector<RID> shared_areas;
+		std::vector<int32_t> areas_first_shapes;
+		// How the shapes are split between the areas, compared when another environment could reuse the set.
+		int32_t areas_split = AREAS_SPLIT_NONE;
+		int32_t areas_chunk_size = 0;
+		// Pools [0, ready_pools) are initialized, the others are waiting for a time-sliced mount.
+		int32_t ready_pools = 0;
 	};
-	// PoolKitSets represent PoolKits organized by their shared area.
+	// PoolKitSets represent PoolKits organized by their collision layer and mask.
 	std::vector<PoolKitSet> pool_sets;
-	// Maps each area RID to the corresponding PoolKitSet index.
-	Dictionary areas_to_pool_set_indices;
-	// Maps each BulletKit to the corresponding PoolKit index.
-	Dictionary kits_to_set_pool_indices;
+	// Maps the ID of each shared area RID to the corresponding PoolKitSet index, and to the set shape index of its first shape.
+	struct AreaSlot {
+		int32_t set_index;
+		int32_t first_shape_index;
+	};
+	std::unordered_map<int32_t, AreaSlot> areas_to_pool_set_indices;
+	// Indexed by the slot assigned to each mounted BulletKit.
+	struct KitSlot {
+		BulletKit* kit;
+		int32_t set_index;
+		int32_t pool_index;
+	};
+	std::vector<KitSlot> kit_slots;
 
 	Node* bullets_environment = nullptr;
 
+	// Pools still to be initialized by the current mount, in order.
+	struct PendingPool {
+		int32_t set_index;
+		int32_t pool_index;
+		int32_t starting_shape_index;
+	};
+	std::vector<PendingPool> pending_pools;
+	int32_t next_pending_pool = 0;
+	// Microseconds spent initializing pools each frame, 0 initializes all of them at once.
+	int64_t mount_budget_usec = 0;
+	bool mounting = false;
+
+	// Sets of the previously mounted environments, whose pools have no active bullets, most recent last.
+	// Mounts reuse whole sets, or take single pools out of them, when the kit and its configuration match.
+	std::vector<PoolKitSet> cached_sets;
+	// Bullets the cached pools can hold after a mount, the least recent sets are freed first.
+	int32_t pool_cache_size = 0;
+
+	// Workers used to process the pools in parallel, started when the environment enables multithreading.
+	BulletsThreadPool thread_pool;
+	std::vector<BulletsPool*> parallel_pools;
+	std::vector<int32_t> parallel_variations;
+	std::vector<int64_t> parallel_commit_usecs;
+	// Large pools are simulated in chunks of this many bullets, so that a single pool can keep many threads busy.
+	static const int32_t SIMULATION_CHUNK_SIZE = 2048;
+	struct SimulationChunk {
+		BulletsPool* pool;
+		int32_t begin;
+		int32_t end;
+		int64_t usec;
+	};
+	std::vector<SimulationChunk> simulation_chunks;
+
+	// Collision backend of the kits using the grid, queried each tick by the registered hurtboxes.
+	struct Hurtbox {
+		int64_t instance_id;
+		BulletsGridShape shape;
+		uint32_t collision_mask;
+	};
+	BulletsGrid collision_grid;
+	bool grid_enabled = false;
+	std::vector<Hurtbox> hurtboxes;
+	std::vector<BulletID> hurtbox_hits;
+	// Hits of the last tick, as consecutive hurtbox node and bullet ID pairs.
+	Array hits;
+
+	// Every active bullet, rebuilt by the first spatial query after bullets have moved or spawned.
+	BulletsGrid query_grid;
+	bool query_grid_dirty = true;
+	std::vector<BulletID> query_hits;
+
+	// Events of the emitters, fired after the pools have been processed so that new bullets move from the next tick.
+	BulletsScheduler scheduler;
+
 	int32_t available_bullets = 0;
 	int32_t active_bullets = 0;
 	int32_t total_bullets = 0;
 
-	Array shared_areas;
 	PoolIntArray invalid_id;
 
-	void _clear_rids();
+	void _process_parallel_pools(float delta);
+	void _update_collision_grid();
+	void _update_query_grid();
+	// Appends to `result` the valid bullets overlapping the shape, of `kit` if it's valid and with `collision_layer` if it's not 0.
+	void _query_bullets(const BulletsGridShape& shape, const Transform2D& transform, const Ref<BulletKit>& kit,
+		int32_t collision_layer, std::vector<BulletID>& result);
+	int32_t _release_in_shape(const BulletsGridShape& shape, const Transform2D& transform, const Ref<BulletKit>& kit, int32_t collision_layer);
+	// Set while release_by_predicate calls the predicate, spawning or releasing bullets would move the marked slots.
+	bool predicate_running = false;
+	bool _is_predicate_running();
+	Array _query(const BulletsGridShape& shape, const Transform2D& transform, const Ref<BulletKit>& kit, int32_t collision_layer);
+	bool _is_pool_reusable(const PoolKit& pool_kit, const PoolKit& cached_pool_kit);
+	bool _reuse_pool_set(int32_t set_index);
+	std::unique_ptr<BulletsPool> _take_cached_pool(const PoolKit& pool_kit, int64_t layer_mask);
+	void _cache_pool_sets();
+	void _prune_pool_cache();
+	Node* _get_parent_hint(NodePath parent_path);
+	void _create_shared_areas(PoolKitSet& set, const Ref<BulletKit>& first_kit);
+	BulletsPoolAreas _get_pool_areas(const PoolKitSet& set, int32_t starting_shape_index, int32_t pool_size);
+	void _mount_pending_pools();
+	void _free_pool_set(PoolKitSet& set);
+	void _clear_pool_sets();
+	void _clear_kit_slots();
+	PoolKit* _get_pool_kit(const Ref<BulletKit>& kit);
+	// Also converts the index of a shape in the area to its index in the set.
+	int32_t _get_pool_set_index(RID area_rid, int32_t& shape_index);
 	int32_t _get_pool_index(int32_t set_index, int32_t bullet_index);
+	BulletID _to_bullet_id(Variant id);
+	PoolIntArray _to_pool_int_array(BulletID id);
+	BulletID _obtain_bullet(Ref<BulletKit> kit);
+	BulletID _get_bullet_from_shape(RID area_rid, int32_t shape_index);
 
 public:
 	static void _register_methods();
@@ -60,15 +179,32 @@ public:
 
 	void _init();
 
+	void _process(float delta);
 	void _physics_process(float delta);
+	// Sends the shape changes the pools queued during the tick, in a single pass.
+	void _flush_shape_changes();
 
 	void mount(Node* bullets_environment);
 	void unmount(Node* bullets_environment);
 	Node* get_bullets_environment();
+	bool is_mounting();
+	// Frees the pools kept for the next mounts.
+	void clear_pool_cache();
 
 	bool spawn_bullet(Ref<BulletKit> kit, Dictionary properties);
+	int32_t spawn_bullets(Ref<BulletKit> kit, PoolVector2Array positions, PoolVector2Array velocities, PoolRealArray rotations);
+	// Same as spawn_bullets, for native callers keeping the values in their own buffers.
+	int32_t _spawn_bullets(const Ref<BulletKit>& kit, const Vector2* positions, const Vector2* velocities, const real_t* rotations, int32_t amount);
 	Variant obtain_bullet(Ref<BulletKit> kit);
+	int64_t obtain_bullet_handle(Ref<BulletKit> kit);
 	bool release_bullet(Variant id);
+	// Bulk releases, each one a single pass over the matching pools. They return how many bullets have been released.
+	int32_t release_all();
+	int32_t release_kit(Ref<BulletKit> kit);
+	int32_t release_in_rect(Rect2 rect, Ref<BulletKit> kit, int32_t collision_layer);
+	int32_t release_in_circle(Vector2 center, float radius, Ref<BulletKit> kit, int32_t collision_layer);
+	int32_t release_older_than(Ref<BulletKit> kit, float lifetime);
+	int32_t release_by_predicate(Ref<BulletKit> kit, Object* target, String method);
 
 	bool is_bullet_valid(Variant id);
 	bool is_kit_valid(Ref<BulletKit> kit);
@@ -81,12 +217,33 @@ public:
 	int32_t get_total_available_bullets();
 	int32_t get_total_active_bullets();
 
+	// Returns a Dictionary with the counters of the last physics tick of each mounted kit, keyed by kit.
+	Dictionary get_frame_stats();
+
 	bool is_bullet_existing(RID area_rid, int32_t shape_index);
 	Variant get_bullet_from_shape(RID area_rid, int32_t shape_index);
+	int64_t get_bullet_handle_from_shape(RID area_rid, int32_t shape_index);
 	Ref<BulletKit> get_kit_from_bullet(Variant id);
 
 	void set_bullet_property(Variant id, String property, Variant value);
 	Variant get_bullet_property(Variant id, String property);
+
+	// Calls `method` of `target` with the seconds the call is late, `delay` seconds from now and every `interval` seconds after it.
+	// An interval of 0 fires the event once. Returns the ID of the event.
+	int64_t schedule_event(Object* target, String method, float delay, float interval);
+	bool cancel_event(int64_t event_id);
+	bool set_event_interval(int64_t event_id, float interval);
+	bool is_event_scheduled(int64_t event_id);
+
+	// Return the handles of the bullets whose collision shape overlaps the area, bullets without a circle
+	// or rectangle shape are tested as points. `kit` can be null and `collision_layer` 0 to match every bullet.
+	Array query_circle(Vector2 center, float radius, Ref<BulletKit> kit, int32_t collision_layer);
+	Array query_rect(Rect2 rect, Ref<BulletKit> kit, int32_t collision_layer);
+	Array query_segment(Vector2 from, Vector2 to, Ref<BulletKit> kit, int32_t collision_layer);
+
+	void add_hurtbox(Node2D* node, Ref<Shape2D> shape, int32_t collision_mask);
+	void remove_hurtbox(Node2D* node);
+	Array get_hits();
 };
 
 #endif
\ No newline at end of file
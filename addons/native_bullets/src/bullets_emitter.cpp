@@ -0,0 +1,213 @@
+#include <SceneTree.hpp>
+#include <Viewport.hpp>
+#include <Engine.hpp>
+
+#include <cmath>
+
+#include "bullets_emitter.h"
+#include "bullets.h"
+
+using namespace godot;
+
+
+void BulletsEmitter::_register_methods() {
+	register_method("_enter_tree", &BulletsEmitter::_enter_tree);
+	register_method("_exit_tree", &BulletsEmitter::_exit_tree);
+	register_method("_physics_process", &BulletsEmitter::_physics_process);
+	register_method("shoot", &BulletsEmitter::shoot);
+	register_method("on_timed_events_request", &BulletsEmitter::on_timed_events_request);
+	register_method("_on_curve_changed", &BulletsEmitter::_on_curve_changed);
+
+	register_property<BulletsEmitter, bool>("enabled", &BulletsEmitter::enabled, true);
+	register_property<BulletsEmitter, Ref<BulletKit>>("bullet_kit", &BulletsEmitter::bullet_kit, Ref<BulletKit>(),
+		GODOT_METHOD_RPC_MODE_DISABLED, GODOT_PROPERTY_USAGE_DEFAULT, GODOT_PROPERTY_HINT_RESOURCE_TYPE, "Resource");
+	register_property<BulletsEmitter, int32_t>("pattern", &BulletsEmitter::pattern, PATTERN_RING,
+		GODOT_METHOD_RPC_MODE_DISABLED, GODOT_PROPERTY_USAGE_DEFAULT, GODOT_PROPERTY_HINT_ENUM, "Ring,Arc,Aimed");
+	register_property<BulletsEmitter, int32_t>("bullets_amount", &BulletsEmitter::bullets_amount, 8,
+		GODOT_METHOD_RPC_MODE_DISABLED, GODOT_PROPERTY_USAGE_DEFAULT, GODOT_PROPERTY_HINT_RANGE, "1,1024");
+	register_property<BulletsEmitter, float>("arc_degrees", &BulletsEmitter::arc_degrees, 90.0f,
+		GODOT_METHOD_RPC_MODE_DISABLED, GODOT_PROPERTY_USAGE_DEFAULT, GODOT_PROPERTY_HINT_RANGE, "0.0,360.0");
+	register_property<BulletsEmitter, float>("bullets_speed", &BulletsEmitter::bullets_speed, 100.0f,
+		GODOT_METHOD_RPC_MODE_DISABLED, GODOT_PROPERTY_USAGE_DEFAULT, GODOT_PROPERTY_HINT_RANGE, "0.0,65535.0");
+	register_property<BulletsEmitter, float>("bullets_spawn_distance", &BulletsEmitter::bullets_spawn_distance, 0.0f,
+		GODOT_METHOD_RPC_MODE_DISABLED, GODOT_PROPERTY_USAGE_DEFAULT, GODOT_PROPERTY_HINT_RANGE, "-512.0,512.0");
+	register_property<BulletsEmitter, NodePath>("target", &BulletsEmitter::target, NodePath());
+
+	register_property<BulletsEmitter, int32_t>("burst_shots", &BulletsEmitter::burst_shots, 1,
+		GODOT_METHOD_RPC_MODE_DISABLED, GODOT_PROPERTY_USAGE_DEFAULT, GODOT_PROPERTY_HINT_RANGE, "1,256");
+	register_property<BulletsEmitter, float>("burst_interval", &BulletsEmitter::burst_interval, 0.1f,
+		GODOT_METHOD_RPC_MODE_DISABLED, GODOT_PROPERTY_USAGE_DEFAULT, GODOT_PROPERTY_HINT_RANGE, "0.0,10.0");
+	register_property<BulletsEmitter, float>("burst_speed_step", &BulletsEmitter::burst_speed_step, 0.0f);
+
+	register_property<BulletsEmitter, float>("fire_interval",
+		&BulletsEmitter::set_fire_interval,
+		&BulletsEmitter::get_fire_interval, 0.0f,
+		GODOT_METHOD_RPC_MODE_DISABLED, GODOT_PROPERTY_USAGE_DEFAULT, GODOT_PROPERTY_HINT_RANGE, "0.0,60.0");
+	register_property<BulletsEmitter, float>("fire_delay", &BulletsEmitter::fire_delay, 0.0f,
+		GODOT_METHOD_RPC_MODE_DISABLED, GODOT_PROPERTY_USAGE_DEFAULT, GODOT_PROPERTY_HINT_RANGE, "0.0,60.0");
+
+	register_property<BulletsEmitter, float>("rotation_per_shot", &BulletsEmitter::rotation_per_shot, 0.0f);
+	register_property<BulletsEmitter, float>("rotation_speed", &BulletsEmitter::rotation_speed, 0.0f);
+	register_property<BulletsEmitter, Ref<Curve>>("rotation_over_time",
+		&BulletsEmitter::set_rotation_over_time,
+		&BulletsEmitter::get_rotation_over_time, Ref<Curve>(),
+		GODOT_METHOD_RPC_MODE_DISABLED, GODOT_PROPERTY_USAGE_DEFAULT, GODOT_PROPERTY_HINT_RESOURCE_TYPE, "Curve");
+	register_property<BulletsEmitter, float>("rotation_curve_duration", &BulletsEmitter::rotation_curve_duration, 1.0f,
+		GODOT_METHOD_RPC_MODE_DISABLED, GODOT_PROPERTY_USAGE_DEFAULT, GODOT_PROPERTY_HINT_RANGE, "0.001,300.0");
+}
+
+void BulletsEmitter::_enter_tree() {
+	if(Engine::get_singleton()->is_editor_hint()) {
+		set_physics_process(false);
+		return;
+	}
+	bullets = Object::cast_to<Bullets>(get_tree()->get_root()->get_node_or_null("Bullets"));
+	if(bullets == nullptr) {
+		ERR_PRINT("BulletsEmitter needs the Bullets autoload!");
+	}
+	_update_fire_event();
+}
+
+void BulletsEmitter::_exit_tree() {
+	if(bullets != nullptr && fire_event_id != 0) {
+		bullets->cancel_event(fire_event_id);
+	}
+	fire_event_id = 0;
+	bullets = nullptr;
+}
+
+void BulletsEmitter::_update_fire_event() {
+	if(bullets == nullptr) {
+		return;
+	}
+	if(fire_event_id != 0 && fire_interval > 0.0f && bullets->set_event_interval(fire_event_id, fire_interval)) {
+		return;
+	}
+	if(fire_event_id != 0) {
+		bullets->cancel_event(fire_event_id);
+		fire_event_id = 0;
+	}
+	if(fire_interval > 0.0f) {
+		fire_event_id = bullets->schedule_event(this, "shoot", fire_delay, fire_interval);
+	}
+}
+
+void BulletsEmitter::_physics_process(float delta) {
+	// rotation_speed and rotation_per_shot are in degrees, like the TimedRotator rotations.
+	pattern_rotation = std::fmod(pattern_rotation + Math::deg2rad(rotation_speed) * delta, (float)(Math_PI * 2.0));
+	if(rotation_lut.is_baked()) {
+		// Keep the time small, like TimedRotator does.
+		rotation_curve_time = std::fmod(rotation_curve_time + delta, rotation_curve_duration);
+	}
+
+	if(burst_shots_left <= 0) {
+		return;
+	}
+	burst_time += delta;
+	// More than one shot can be late in the same tick, each one catches up by its own leftover.
+	while(burst_shots_left > 0 && burst_time >= burst_interval) {
+		burst_time -= burst_interval;
+		burst_shots_left -= 1;
+		burst_shot_index += 1;
+		_fire(burst_time, burst_shot_index);
+	}
+}
+
+float BulletsEmitter::_get_pattern_rotation() {
+	float rotation = pattern_rotation;
+	if(rotation_lut.is_baked()) {
+		rotation += Math::deg2rad(rotation_lut.sample(rotation_curve_time / rotation_curve_duration));
+	}
+	return rotation;
+}
+
+void BulletsEmitter::_fire(float leftover, int32_t shot_index) {
+	if(!enabled || bullets == nullptr || bullet_kit.is_null() || bullets_amount <= 0) {
+		return;
+	}
+	Transform2D global_transform = get_global_transform();
+	Vector2 origin = global_transform.get_origin();
+
+	float base_rotation = global_transform.get_rotation();
+	if(pattern == PATTERN_AIMED && !target.is_empty()) {
+		Node2D* target_node = Object::cast_to<Node2D>(get_node_or_null(target));
+		if(target_node != nullptr) {
+			base_rotation = (target_node->get_global_position() - origin).angle();
+		}
+	}
+	base_rotation += _get_pattern_rotation();
+
+	float first_rotation = base_rotation;
+	float rotation_step = 0.0f;
+	if(pattern == PATTERN_RING) {
+		rotation_step = (float)(Math_PI * 2.0) / bullets_amount;
+	} else if(bullets_amount > 1) {
+		float arc = Math::deg2rad(arc_degrees);
+		first_rotation -= arc / 2.0f;
+		rotation_step = arc / (bullets_amount - 1);
+	}
+	float speed = bullets_speed + burst_speed_step * shot_index;
+
+	positions.resize(bullets_amount);
+	velocities.resize(bullets_amount);
+	rotations.resize(bullets_amount);
+	for(int32_t i = 0; i < bullets_amount; i++) {
+		float rotation = first_rotation + rotation_step * i;
+		Vector2 direction = Vector2(std::cos(rotation), std::sin(rotation));
+
+		velocities[i] = direction * speed;
+		// Move late bullets to where they would be if they had been spawned on time.
+		positions[i] = origin + direction * bullets_spawn_distance + velocities[i] * leftover;
+		rotations[i] = rotation;
+	}
+	bullets->_spawn_bullets(bullet_kit, positions.data(), velocities.data(), rotations.data(), bullets_amount);
+
+	pattern_rotation = std::fmod(pattern_rotation + Math::deg2rad(rotation_per_shot), (float)(Math_PI * 2.0));
+}
+
+void BulletsEmitter::shoot(float recover_seconds) {
+	if(!enabled) {
+		return;
+	}
+	burst_shots_left = burst_shots - 1;
+	burst_shot_index = 0;
+	burst_time = recover_seconds;
+	_fire(recover_seconds, 0);
+	// Fire the shots of the burst that are already late.
+	_physics_process(0.0f);
+}
+
+void BulletsEmitter::on_timed_events_request(Node* timed_events) {
+	timed_events->connect("event_with_leftover", this, "shoot");
+}
+
+void BulletsEmitter::set_fire_interval(float interval) {
+	fire_interval = interval;
+	_update_fire_event();
+}
+
+float BulletsEmitter::get_fire_interval() {
+	return fire_interval;
+}
+
+void BulletsEmitter::set_rotation_over_time(Ref<Curve> curve) {
+	if(rotation_over_time == curve) {
+		return;
+	}
+	if(rotation_over_time.is_valid()) {
+		rotation_over_time->disconnect("changed", this, "_on_curve_changed");
+	}
+	rotation_over_time = curve;
+	if(rotation_over_time.is_valid()) {
+		rotation_over_time->connect("changed", this, "_on_curve_changed");
+	}
+	_on_curve_changed();
+}
+
+Ref<Curve> BulletsEmitter::get_rotation_over_time() {
+	return rotation_over_time;
+}
+
+void BulletsEmitter::_on_curve_changed() {
+	rotation_lut.bake(rotation_over_time);
+}
\ No newline at end of file
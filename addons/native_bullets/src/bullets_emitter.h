@@ -0,0 +1,103 @@
+#ifndef BULLETS_EMITTER_H
+#define BULLETS_EMITTER_H
+
+#include <Godot.hpp>
+#include <Node2D.hpp>
+#include <Curve.hpp>
+
+#include <vector>
+
+#include "bullet_kit.h"
+#include "curve_lut.h"
+
+using namespace godot;
+
+class Bullets;
+
+
+// Spawns patterns of bullets from its global transform, replacing a BulletsSpawner with a child node per bullet.
+// Each shot is computed and spawned natively, with a single call to the pool.
+class BulletsEmitter : public Node2D {
+	GODOT_CLASS(BulletsEmitter, Node2D)
+
+public:
+	enum Pattern {
+		// Bullets evenly spread all around the emitter.
+		PATTERN_RING = 0,
+		// Bullets evenly spread over `arc_degrees`, centered on the emitter rotation.
+		PATTERN_ARC = 1,
+		// Same as an arc, centered on the direction of the target node.
+		PATTERN_AIMED = 2
+	};
+
+	bool enabled = true;
+	Ref<BulletKit> bullet_kit;
+	int32_t pattern = PATTERN_RING;
+	int32_t bullets_amount = 8;
+	float arc_degrees = 90.0f;
+	float bullets_speed = 100.0f;
+	float bullets_spawn_distance = 0.0f;
+	NodePath target;
+
+	// Shots fired by each call to shoot, `burst_interval` seconds apart.
+	// Each shot of a burst is faster than the previous one by `burst_speed_step`, staggering the bullets.
+	int32_t burst_shots = 1;
+	float burst_interval = 0.1f;
+	float burst_speed_step = 0.0f;
+
+	// Shoots every `fire_interval` seconds through the Bullets scheduler, starting `fire_delay` seconds after entering the tree.
+	// An interval of 0 leaves the shots to the calls to shoot, like the ones of a TimedEvents node.
+	float fire_interval = 0.0f;
+	float fire_delay = 0.0f;
+
+	// Rotation of the pattern, added to the emitter one.
+	// Spirals are patterns rotating after each shot, like a TimedRotator the rotation can also follow a curve.
+	float rotation_per_shot = 0.0f;
+	float rotation_speed = 0.0f;
+	Ref<Curve> rotation_over_time;
+	float rotation_curve_duration = 1.0f;
+
+private:
+	CurveLUT rotation_lut;
+	// Rotation accumulated by rotation_per_shot and rotation_speed, in radians.
+	float pattern_rotation = 0.0f;
+	float rotation_curve_time = 0.0f;
+
+	// Shots of the current burst still to fire, and the time since the last one.
+	int32_t burst_shots_left = 0;
+	int32_t burst_shot_index = 0;
+	float burst_time = 0.0f;
+
+	Bullets* bullets = nullptr;
+	// ID of the event of the Bullets scheduler, 0 if there is none.
+	int64_t fire_event_id = 0;
+	std::vector<Vector2> positions;
+	std::vector<Vector2> velocities;
+	std::vector<real_t> rotations;
+
+	float _get_pattern_rotation();
+	void _fire(float leftover, int32_t shot_index);
+	void _update_fire_event();
+
+public:
+	static void _register_methods();
+
+	void _init() {}
+	void _enter_tree();
+	void _exit_tree();
+	void _physics_process(float delta);
+
+	// Starts a burst, `recover_seconds` is how late the first shot is, as reported by TimedEvents.
+	void shoot(float recover_seconds);
+	// Called by TimedEvents nodes when they wish to automatically connect to other nodes.
+	void on_timed_events_request(Node* timed_events);
+
+	void set_fire_interval(float interval);
+	float get_fire_interval();
+
+	void set_rotation_over_time(Ref<Curve> curve);
+	Ref<Curve> get_rotation_over_time();
+	void _on_curve_changed();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,201 @@
+#include <CircleShape2D.hpp>
+#include <RectangleShape2D.hpp>
+
+#include <cmath>
+#include <cstdint>
+
+#include "bullets_grid.h"
+
+using namespace godot;
+
+
+bool BulletsGridShape::set_from(Ref<Shape2D> shape) {
+	CircleShape2D* circle_shape = Object::cast_to<CircleShape2D>(shape.ptr());
+	if(circle_shape != nullptr) {
+		circle = true;
+		radius = circle_shape->get_radius();
+		return true;
+	}
+	RectangleShape2D* rectangle_shape = Object::cast_to<RectangleShape2D>(shape.ptr());
+	if(rectangle_shape != nullptr) {
+		circle = false;
+		extents = rectangle_shape->get_extents();
+		return true;
+	}
+	return false;
+}
+
+BulletsGrid::PlacedShape BulletsGrid::_place(const BulletsGridShape& shape, const Transform2D& transform) {
+	PlacedShape placed;
+	placed.circle = shape.circle;
+	placed.center = transform.get_origin();
+
+	Vector2 axis_x = transform.elements[0];
+	Vector2 axis_y = transform.elements[1];
+	float scale_x = axis_x.length();
+	float scale_y = axis_y.length();
+
+	if(shape.circle) {
+		placed.radius = shape.radius * Math::max(scale_x, scale_y);
+		placed.half_size = Vector2(placed.radius, placed.radius);
+	} else {
+		placed.radius = 0.0f;
+		placed.axis_x = scale_x > 0.0f ? axis_x / scale_x : Vector2(1.0f, 0.0f);
+		placed.axis_y = scale_y > 0.0f ? axis_y / scale_y : Vector2(0.0f, 1.0f);
+		placed.extents = Vector2(shape.extents.x * scale_x, shape.extents.y * scale_y);
+		placed.half_size = Vector2(
+			std::abs(placed.axis_x.x) * placed.extents.x + std::abs(placed.axis_y.x) * placed.extents.y,
+			std::abs(placed.axis_x.y) * placed.extents.x + std::abs(placed.axis_y.y) * placed.extents.y);
+	}
+	return placed;
+}
+
+bool BulletsGrid::_overlaps(const PlacedShape& a, const PlacedShape& b) {
+	Vector2 distance = b.center - a.center;
+
+	// Circles include their boundary, so that points (circles without radius) can be found too.
+	if(a.circle && b.circle) {
+		float radii = a.radius + b.radius;
+		return distance.length_squared() <= radii * radii;
+	}
+	if(a.circle || b.circle) {
+		const PlacedShape& circle = a.circle ? a : b;
+		const PlacedShape& rectangle = a.circle ? b : a;
+
+		// Find the point of the rectangle closest to the circle center, in the rectangle space.
+		Vector2 to_circle = circle.center - rectangle.center;
+		Vector2 local = Vector2(to_circle.dot(rectangle.axis_x), to_circle.dot(rectangle.axis_y));
+		Vector2 closest = Vector2(Math::clamp(local.x, -rectangle.extents.x, rectangle.extents.x),
+			Math::clamp(local.y, -rectangle.extents.y, rectangle.extents.y));
+		return (local - closest).length_squared() <= circle.radius * circle.radius;
+	}
+	// Separating axis test between two oriented rectangles.
+	const Vector2 axes[4] = { a.axis_x, a.axis_y, b.axis_x, b.axis_y };
+	for(int32_t i = 0; i < 4; i++) {
+		float projected_a = a.extents.x * std::abs(a.axis_x.dot(axes[i])) + a.extents.y * std::abs(a.axis_y.dot(axes[i]));
+		float projected_b = b.extents.x * std::abs(b.axis_x.dot(axes[i])) + b.extents.y * std::abs(b.axis_y.dot(axes[i]));
+		if(std::abs(distance.dot(axes[i])) >= projected_a + projected_b) {
+			return false;
+		}
+	}
+	return true;
+}
+
+int32_t BulletsGrid::_get_cell(float position) {
+	// Casting values outside of the int32 range is undefined, far away positions share the border cells.
+	double cell = std::floor((double)position / cell_size);
+	if(!(cell > (double)INT32_MIN)) {
+		// Also catches NaN.
+		return INT32_MIN;
+	}
+	if(cell > (double)INT32_MAX) {
+		return INT32_MAX;
+	}
+	return (int32_t)cell;
+}
+
+int32_t BulletsGrid::_get_bucket(int32_t cell_x, int32_t cell_y) {
+	return (int32_t)(((uint32_t)cell_x * 73856093u) ^ ((uint32_t)cell_y * 19349663u)) & buckets_mask;
+}
+
+void BulletsGrid::set_cell_size(float cell_size) {
+	this->cell_size = cell_size > 0.0f ? cell_size : 64.0f;
+}
+
+float BulletsGrid::get_cell_size() {
+	return cell_size;
+}
+
+void BulletsGrid::clear() {
+	entries.clear();
+	max_half_size = Vector2();
+}
+
+void BulletsGrid::add_bullet(BulletID id, uint32_t layer, const BulletsGridShape& shape, const Transform2D& transform) {
+	entries.push_back({ _place(shape, transform), id, layer });
+
+	const Vector2& half_size = entries.back().shape.half_size;
+	max_half_size.x = Math::max(max_half_size.x, half_size.x);
+	max_half_size.y = Math::max(max_half_size.y, half_size.y);
+}
+
+void BulletsGrid::build() {
+	// Keep the buckets sparse, about half of them empty.
+	int32_t buckets_amount = 64;
+	while(buckets_amount < entries.size() * 2) {
+		buckets_amount <<= 1;
+	}
+	buckets_mask = buckets_amount - 1;
+
+	// Counting sort of the entries by bucket.
+	bucket_starts.assign(buckets_amount + 1, 0);
+	bucket_entries.resize(entries.size());
+	stamps.assign(entries.size(), query_stamp);
+
+	entry_buckets.resize(entries.size());
+	for(int32_t i = 0; i < entries.size(); i++) {
+		const Vector2& center = entries[i].shape.center;
+		entry_buckets[i] = _get_bucket(_get_cell(center.x), _get_cell(center.y));
+		bucket_starts[entry_buckets[i] + 1]++;
+	}
+	for(int32_t i = 0; i < buckets_amount; i++) {
+		bucket_starts[i + 1] += bucket_starts[i];
+	}
+	bucket_cursors.assign(bucket_starts.begin(), bucket_starts.end() - 1);
+	for(int32_t i = 0; i < entries.size(); i++) {
+		bucket_entries[bucket_cursors[entry_buckets[i]]++] = i;
+	}
+}
+
+void BulletsGrid::query(const BulletsGridShape& shape, const Transform2D& transform, uint32_t mask, std::vector<BulletID>& hits) {
+	if(entries.empty()) {
+		return;
+	}
+	PlacedShape placed = _place(shape, transform);
+
+	// Entries are hashed by their origin, grow the area by the largest entry to find all the overlapping ones.
+	Vector2 reach = placed.half_size + max_half_size;
+	Vector2 begin = placed.center - reach;
+	Vector2 end = placed.center + reach;
+	// Scripts can query infinite areas, like a circle covering the whole screen.
+	bool finite = std::isfinite(begin.x) && std::isfinite(begin.y) && std::isfinite(end.x) && std::isfinite(end.y);
+	int64_t begin_x = finite ? _get_cell(begin.x) : 0;
+	int64_t begin_y = finite ? _get_cell(begin.y) : 0;
+	int64_t end_x = finite ? _get_cell(end.x) : 0;
+	int64_t end_y = finite ? _get_cell(end.y) : 0;
+
+	query_stamp++;
+	if(query_stamp == 0) {
+		// The counter wrapped around, stale stamps could match again.
+		stamps.assign(entries.size(), 0);
+		query_stamp = 1;
+	}
+
+	auto test_entry = [&](int32_t index) {
+		if(stamps[index] == query_stamp) {
+			return;
+		}
+		stamps[index] = query_stamp;
+
+		const Entry& entry = entries[index];
+		if((entry.layer & mask) != 0 && _overlaps(placed, entry.shape)) {
+			hits.push_back(entry.id);
+		}
+	};
+
+	if(!finite || (end_x - begin_x + 1) * (end_y - begin_y + 1) > buckets_mask + 1) {
+		// The shape covers more cells than buckets, testing every entry is cheaper.
+		for(int32_t i = 0; i < entries.size(); i++) {
+			test_entry(i);
+		}
+		return;
+	}
+	for(int64_t cell_y = begin_y; cell_y <= end_y; cell_y++) {
+		for(int64_t cell_x = begin_x; cell_x <= end_x; cell_x++) {
+			int32_t bucket = _get_bucket((int32_t)cell_x, (int32_t)cell_y);
+			for(int32_t i = bucket_starts[bucket]; i < bucket_starts[bucket + 1]; i++) {
+				test_entry(bucket_entries[i]);
+			}
+		}
+	}
+}
\ No newline at end of file
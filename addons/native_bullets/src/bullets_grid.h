@@ -0,0 +1,84 @@
+#ifndef BULLETS_GRID_H
+#define BULLETS_GRID_H
+
+#include <Godot.hpp>
+#include <Shape2D.hpp>
+
+#include <vector>
+
+#include "bullet.h"
+
+using namespace godot;
+
+
+// Shape of a bullet or hurtbox tested by the grid, only circles and rectangles are supported.
+struct BulletsGridShape {
+	bool circle = true;
+	float radius = 0.0f;
+	Vector2 extents;
+
+	// Returns false if the type of the shape is not supported.
+	bool set_from(Ref<Shape2D> shape);
+};
+
+// Uniform grid used as collision backend for the bullets, as an alternative to Physics2DServer areas.
+// Bullets are hashed by the cell containing their origin, the grid is rebuilt from scratch each tick.
+class BulletsGrid {
+
+public:
+	// A shape placed in the world. Rectangles keep their orientation, circles are scaled by the largest axis.
+	struct PlacedShape {
+		bool circle;
+		float radius;
+		Vector2 center;
+		Vector2 axis_x;
+		Vector2 axis_y;
+		Vector2 extents;
+		// Half size of the bounding box.
+		Vector2 half_size;
+	};
+	// Also used by the pools to test their bullets without building a grid.
+	static PlacedShape _place(const BulletsGridShape& shape, const Transform2D& transform);
+	static bool _overlaps(const PlacedShape& a, const PlacedShape& b);
+
+private:
+	struct Entry {
+		PlacedShape shape;
+		BulletID id;
+		uint32_t layer;
+	};
+
+	float cell_size = 64.0f;
+	std::vector<Entry> entries;
+	// Largest bounding box half size of the entries, used to grow the queried area.
+	Vector2 max_half_size;
+
+	int32_t buckets_mask = 0;
+	// Entries indices sorted by bucket, bucket_starts[b] is the first one in bucket b.
+	std::vector<int32_t> bucket_starts;
+	std::vector<int32_t> bucket_entries;
+	// Scratch buffers of build, kept to avoid allocating each tick.
+	std::vector<int32_t> entry_buckets;
+	std::vector<int32_t> bucket_cursors;
+	// Avoids testing twice the same entry when different cells share a bucket.
+	std::vector<uint32_t> stamps;
+	uint32_t query_stamp = 0;
+
+	// Returns the cell containing the coordinate, clamped to the int32 range.
+	int32_t _get_cell(float position);
+	int32_t _get_bucket(int32_t cell_x, int32_t cell_y);
+
+public:
+	void set_cell_size(float cell_size);
+	float get_cell_size();
+
+	void clear();
+	void add_bullet(BulletID id, uint32_t layer, const BulletsGridShape& shape, const Transform2D& transform);
+	// Sorts the added bullets into the cells, must be called before querying.
+	void build();
+
+	// Appends to `hits` the bullets overlapping the shape whose layer is in `mask`.
+	void query(const BulletsGridShape& shape, const Transform2D& transform, uint32_t mask, std::vector<BulletID>& hits);
+};
+
+#endif
\ No newline at end of file
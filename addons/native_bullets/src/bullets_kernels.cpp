@@ -0,0 +1,146 @@
+#include "bullets_kernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define BULLETS_KERNELS_X86_64
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define BULLETS_TARGET_AVX2
+#else
+#define BULLETS_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+using namespace godot;
+
+
+// The kernels read the origins straight from the transforms memory.
+static_assert(sizeof(Transform2D) == 6 * sizeof(float), "Transform2D must be made of 6 floats.");
+static_assert(sizeof(Vector2) == 2 * sizeof(float), "Vector2 must be made of 2 floats.");
+
+typedef void (*IntegrateFunction)(Transform2D*, const Vector2*, float*, uint8_t*, int32_t, int32_t, Vector2, Vector2, float);
+
+static void integrate_scalar(Transform2D* transforms, const Vector2* velocities, float* lifetimes, uint8_t* deaths,
+		int32_t begin, int32_t end, Vector2 rect_begin, Vector2 rect_end, float delta) {
+	for(int32_t i = begin; i < end; i++) {
+		Vector2 origin = transforms[i].get_origin() + velocities[i] * delta;
+		transforms[i].set_origin(origin);
+
+		// Same comparisons as Rect2::has_point.
+		bool dead = origin.x < rect_begin.x || origin.y < rect_begin.y || origin.x >= rect_end.x || origin.y >= rect_end.y;
+		deaths[i] = dead;
+		if(!dead) {
+			lifetimes[i] += delta;
+		}
+	}
+}
+
+#ifdef BULLETS_KERNELS_X86_64
+
+// Two bullets for each 128 bits register: velocities are contiguous, origins are gathered from the transforms.
+static void integrate_sse2(Transform2D* transforms, const Vector2* velocities, float* lifetimes, uint8_t* deaths,
+		int32_t begin, int32_t end, Vector2 rect_begin, Vector2 rect_end, float delta) {
+	const __m128 deltas = _mm_set1_ps(delta);
+	const __m128 lows = _mm_setr_ps(rect_begin.x, rect_begin.y, rect_begin.x, rect_begin.y);
+	const __m128 highs = _mm_setr_ps(rect_end.x, rect_end.y, rect_end.x, rect_end.y);
+
+	int32_t i = begin;
+	for(; i + 2 <= end; i += 2) {
+		__m64* origin_a = (__m64*)&transforms[i].elements[2];
+		__m64* origin_b = (__m64*)&transforms[i + 1].elements[2];
+
+		__m128 origins = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), origin_a), origin_b);
+		origins = _mm_add_ps(origins, _mm_mul_ps(_mm_loadu_ps((const float*)&velocities[i]), deltas));
+		_mm_storel_pi(origin_a, origins);
+		_mm_storeh_pi(origin_b, origins);
+
+		int32_t outside = _mm_movemask_ps(_mm_or_ps(_mm_cmplt_ps(origins, lows), _mm_cmpge_ps(origins, highs)));
+		for(int32_t j = 0; j < 2; j++) {
+			bool dead = (outside >> (j * 2)) & 0x3;
+			deaths[i + j] = dead;
+			if(!dead) {
+				lifetimes[i + j] += delta;
+			}
+		}
+	}
+	integrate_scalar(transforms, velocities, lifetimes, deaths, i, end, rect_begin, rect_end, delta);
+}
+
+// Four bullets for each 256 bits register.
+BULLETS_TARGET_AVX2
+static void integrate_avx2(Transform2D* transforms, const Vector2* velocities, float* lifetimes, uint8_t* deaths,
+		int32_t begin, int32_t end, Vector2 rect_begin, Vector2 rect_end, float delta) {
+	const __m256 deltas = _mm256_set1_ps(delta);
+	const __m256 lows = _mm256_setr_ps(rect_begin.x, rect_begin.y, rect_begin.x, rect_begin.y,
+		rect_begin.x, rect_begin.y, rect_begin.x, rect_begin.y);
+	const __m256 highs = _mm256_setr_ps(rect_end.x, rect_end.y, rect_end.x, rect_end.y,
+		rect_end.x, rect_end.y, rect_end.x, rect_end.y);
+
+	int32_t i = begin;
+	for(; i + 4 <= end; i += 4) {
+		__m64* origin_a = (__m64*)&transforms[i].elements[2];
+		__m64* origin_b = (__m64*)&transforms[i + 1].elements[2];
+		__m64* origin_c = (__m64*)&transforms[i + 2].elements[2];
+		__m64* origin_d = (__m64*)&transforms[i + 3].elements[2];
+
+		__m128 origins_ab = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), origin_a), origin_b);
+		__m128 origins_cd = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), origin_c), origin_d);
+		__m256 origins = _mm256_insertf128_ps(_mm256_castps128_ps256(origins_ab), origins_cd, 1);
+
+		origins = _mm256_add_ps(origins, _mm256_mul_ps(_mm256_loadu_ps((const float*)&velocities[i]), deltas));
+		origins_ab = _mm256_castps256_ps128(origins);
+		origins_cd = _mm256_extractf128_ps(origins, 1);
+		_mm_storel_pi(origin_a, origins_ab);
+		_mm_storeh_pi(origin_b, origins_ab);
+		_mm_storel_pi(origin_c, origins_cd);
+		_mm_storeh_pi(origin_d, origins_cd);
+
+		int32_t outside = _mm256_movemask_ps(_mm256_or_ps(_mm256_cmp_ps(origins, lows, _CMP_LT_OQ),
+			_mm256_cmp_ps(origins, highs, _CMP_GE_OQ)));
+		for(int32_t j = 0; j < 4; j++) {
+			bool dead = (outside >> (j * 2)) & 0x3;
+			deaths[i + j] = dead;
+			if(!dead) {
+				lifetimes[i + j] += delta;
+			}
+		}
+	}
+	integrate_scalar(transforms, velocities, lifetimes, deaths, i, end, rect_begin, rect_end, delta);
+}
+
+static bool cpu_has_avx2() {
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if(info[0] < 7) {
+		return false;
+	}
+	__cpuid(info, 1);
+	// AVX must be supported by the CPU and its registers saved by the OS.
+	if(!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || (_xgetbv(0) & 0x6) != 0x6) {
+		return false;
+	}
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+static IntegrateFunction select_integrate_function() {
+#ifdef BULLETS_KERNELS_X86_64
+	// SSE2 is always available on x86-64.
+	return cpu_has_avx2() ? integrate_avx2 : integrate_sse2;
+#else
+	return integrate_scalar;
+#endif
+}
+
+void integrate_bullets(Transform2D* transforms, const Vector2* velocities, float* lifetimes, uint8_t* deaths,
+		int32_t begin, int32_t end, Rect2 rect, float delta) {
+	static const IntegrateFunction integrate_function = select_integrate_function();
+
+	integrate_function(transforms, velocities, lifetimes, deaths, begin, end, rect.position, rect.position + rect.size, delta);
+}
\ No newline at end of file
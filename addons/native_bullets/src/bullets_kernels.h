@@ -0,0 +1,16 @@
+#ifndef BULLETS_KERNELS_H
+#define BULLETS_KERNELS_H
+
+#include <Godot.hpp>
+
+using namespace godot;
+
+
+// Moves the bullets in the slots [begin, end) by velocity * delta, marks in `deaths` the ones whose origin
+// falls outside `rect` and increases the lifetime of the others.
+// Vectorized when the CPU allows it, the results are identical to the scalar version
+// (Rect2::has_point semantics, no fused multiply-add).
+void integrate_bullets(Transform2D* transforms, const Vector2* velocities, float* lifetimes, uint8_t* deaths,
+	int32_t begin, int32_t end, Rect2 rect, float delta);
+
+#endif
\ No newline at end of file
@@ -1,4 +1,12 @@
+#include <VisualServer.hpp>
+#include <World2D.hpp>
+#include <Viewport.hpp>
+
+#include <algorithm>
+#include <chrono>
+
 #include "bullets_pool.h"
+#include "bullets_kernels.h"
 
 using namespace godot;
 
@@ -7,10 +15,349 @@ BulletsPool::BulletsPool() {}
 
 BulletsPool::~BulletsPool() {}
 
+void BulletsPool::_set_server_backend(BulletsServerBackend* backend) {
+	server_backend = backend;
+}
+
+RID BulletsPool::_find_canvas(Node* parent_hint, Viewport** viewport, CanvasLayer** canvas_layer) {
+	*viewport = nullptr;
+	*canvas_layer = nullptr;
+
+	Node* n = parent_hint;
+	while (n) {
+		if (!*canvas_layer) {
+			*canvas_layer = Object::cast_to<CanvasLayer>(n);
+		}
+		*viewport = Object::cast_to<Viewport>(n);
+		if (*viewport) {
+			break;
+		}
+
+		n = n->get_parent();
+	}
+	if (*canvas_layer) {
+		return (*canvas_layer)->get_canvas();
+	}
+	return (*viewport)->find_world_2d()->get_canvas();
+}
+
+BulletsPoolKitSettings::BulletsPoolKitSettings(const Ref<BulletKit>& kit) {
+	if(kit->material.is_valid()) {
+		material = kit->material->get_rid();
+	}
+	if(kit->collision_shape.is_valid()) {
+		collision_shape = kit->collision_shape->get_rid();
+	}
+	collisions_enabled = kit->collisions_enabled;
+	collision_layer = kit->collision_layer;
+	collision_mask = kit->collision_mask;
+	collision_backend = kit->collision_backend;
+	unique_modulate_component = kit->unique_modulate_component;
+	rendering_mode = kit->rendering_mode;
+}
+
+bool BulletsPoolKitSettings::operator==(const BulletsPoolKitSettings& other) const {
+	return material == other.material && collision_shape == other.collision_shape &&
+		collisions_enabled == other.collisions_enabled && collision_layer == other.collision_layer &&
+		collision_mask == other.collision_mask && collision_backend == other.collision_backend &&
+		unique_modulate_component == other.unique_modulate_component && rendering_mode == other.rendering_mode;
+}
+
+void BulletsPool::_read_grid_shapes(const Ref<BulletKit>& kit) {
+	if(grid_collisions_enabled && !grid_shape.set_from(kit->collision_shape)) {
+		ERR_PRINT("The collision grid only supports CircleShape2D and RectangleShape2D!");
+		grid_collisions_enabled = false;
+	}
+	query_shape = BulletsGridShape();
+	if(kit->collision_shape.is_valid()) {
+		// Unsupported shapes are silently queried as points, they are not required to collide.
+		BulletsGridShape shape;
+		if(shape.set_from(kit->collision_shape)) {
+			query_shape = shape;
+		}
+	}
+}
+
+bool BulletsPool::_is_reusable(const Ref<BulletKit>& kit, Node* parent_hint) {
+	Viewport* viewport;
+	CanvasLayer* canvas_layer;
+	return kit_settings == BulletsPoolKitSettings(kit) && _is_canvas_valid() &&
+		_find_canvas(parent_hint, &viewport, &canvas_layer) == canvas_parent;
+}
+
+bool BulletsPool::_is_canvas_valid() {
+	return godot::core_1_2_api->godot_instance_from_id(canvas_owner_id) != nullptr;
+}
+
+bool BulletsPool::_set_parent_hint(Node* parent_hint) {
+	Viewport* viewport;
+	CanvasLayer* canvas_layer;
+	if(_find_canvas(parent_hint, &viewport, &canvas_layer) != canvas_parent) {
+		return false;
+	}
+	this->viewport = viewport;
+	this->canvas_layer = canvas_layer;
+	return true;
+}
+
 int32_t BulletsPool::get_available_bullets() {
 	return available_bullets;
 }
 
 int32_t BulletsPool::get_active_bullets() {
 	return active_bullets;
+}
+
+int32_t BulletsPool::get_high_water_mark() {
+	return high_water_mark;
+}
+
+int32_t BulletsPool::get_allocated_bullets() {
+	return allocated_bullets;
+}
+
+void BulletsPool::_set_elastic(int32_t initial_size, int32_t growth_step, float shrink_delay) {
+	this->initial_size = Math::max(initial_size, 1);
+	this->growth_step = Math::max(growth_step, 1);
+	this->shrink_delay = Math::max(shrink_delay, 0.0f);
+}
+
+void BulletsPool::_update_capacity(float delta) {
+	if(growth_step <= 0 || allocated_bullets <= initial_size || active_bullets + growth_step > allocated_bullets) {
+		idle_time = 0.0f;
+		return;
+	}
+	idle_time += delta;
+	if(idle_time < shrink_delay) {
+		return;
+	}
+	idle_time = 0.0f;
+
+	// Slots can only be removed above the highest shape index in use.
+	int32_t used_slots = 0;
+	for(int32_t i = 0; i < active_bullets; i++) {
+		used_slots = Math::max(used_slots, shape_indices[i] - starting_shape_index + 1);
+	}
+	// Keep a step of free slots, so that the pool doesn't grow again right away.
+	int32_t amount = Math::max(Math::max(initial_size, used_slots), active_bullets + growth_step);
+	if(amount < allocated_bullets) {
+		_reallocate(amount);
+	}
+}
+
+const BulletsPoolStats& BulletsPool::get_frame_stats() {
+	return frame_stats;
+}
+
+void BulletsPool::_add_frame_times(int64_t simulation_usec, int64_t commit_usec) {
+	stats.simulation_usec += simulation_usec;
+	stats.commit_usec += commit_usec;
+}
+
+void BulletsPool::_end_frame_stats() {
+	frame_stats = stats;
+	stats = BulletsPoolStats();
+}
+
+int32_t BulletsPool::_process(float delta) {
+	auto start = std::chrono::steady_clock::now();
+	if(static_bullets) {
+		for(int32_t i = 0; i < active_bullets; i++) {
+			lifetimes[i] += delta;
+		}
+		_add_frame_times(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count(), 0);
+		return 0;
+	}
+	_simulate(delta, 0, active_bullets);
+	auto simulated = std::chrono::steady_clock::now();
+	int32_t amount_variation = _commit();
+	auto committed = std::chrono::steady_clock::now();
+
+	_add_frame_times(std::chrono::duration_cast<std::chrono::microseconds>(simulated - start).count(),
+		std::chrono::duration_cast<std::chrono::microseconds>(committed - simulated).count());
+	return amount_variation;
+}
+
+void BulletsPool::_integrate_bullets(float delta, int32_t begin, int32_t end) {
+	integrate_bullets(transforms.data(), velocities.data(), lifetimes.data(), deaths.data(), begin, end, active_rect, delta);
+}
+
+void BulletsPool::_prepare_simulation() {}
+
+bool BulletsPool::_is_thread_safe() {
+	return false;
+}
+
+void BulletsPool::_set_deferring_server_commands(bool deferring) {
+	deferring_server_commands = deferring;
+}
+
+void BulletsPool::_flush_server_commands() {
+	for(int32_t i = 0; i < server_commands.size(); i++) {
+		const ServerCommand& command = server_commands[i];
+		switch(command.type) {
+			case SET_ITEM_TRANSFORM:
+				server_backend->canvas_item_set_transform(command.rid, command.transform);
+				break;
+			case HIDE_ITEM:
+				server_backend->canvas_item_set_visible(command.rid, false);
+				break;
+		}
+	}
+	// Keep the capacity, the next frame will record a similar amount of commands.
+	server_commands.clear();
+}
+
+void BulletsPool::_add_shapes(RID shape) {
+	int32_t area_shape_index;
+	for(int32_t i = 0; i < pool_size; i++) {
+		server_backend->area_add_shape(shared_areas.get_area(starting_shape_index + i, area_shape_index), shape);
+	}
+}
+
+void BulletsPool::_reset_shapes() {
+	queued_shapes.clear();
+	if(!collisions_enabled) {
+		shape_flags.clear();
+		shape_transforms.clear();
+		return;
+	}
+	// Shapes are added disabled, with an identity transform.
+	shape_flags.assign(pool_size, 0);
+	shape_transforms.assign(pool_size, Transform2D());
+}
+
+void BulletsPool::_flush_shape_changes() {
+	for(int32_t i = 0; i < queued_shapes.size(); i++) {
+		int32_t offset = queued_shapes[i];
+		uint8_t& flags = shape_flags[offset];
+		flags &= ~SHAPE_QUEUED;
+
+		bool enabled = flags & SHAPE_ENABLED;
+		int32_t area_shape_index;
+		RID area = shared_areas.get_area(starting_shape_index + offset, area_shape_index);
+		// Disabled shapes keep their transform until they are enabled again.
+		if(enabled && (flags & SHAPE_TRANSFORM_DIRTY)) {
+			server_backend->area_set_shape_transform(area, area_shape_index, shape_transforms[offset]);
+			flags &= ~SHAPE_TRANSFORM_DIRTY;
+			stats.server_calls++;
+		}
+		if(enabled != (bool)(flags & SHAPE_SERVER_ENABLED)) {
+			server_backend->area_set_shape_disabled(area, area_shape_index, !enabled);
+			flags ^= SHAPE_SERVER_ENABLED;
+			stats.server_calls++;
+		}
+	}
+	queued_shapes.clear();
+}
+
+void BulletsPool::_create_multimesh(Vector2 texture_size, RID texture_rid) {
+	// A quad with the size of the texture, centered on the bullet origin.
+	Vector2 half_size = texture_size / 2.0f;
+
+	PoolVector2Array vertices = PoolVector2Array();
+	vertices.append(Vector2(-half_size.x, -half_size.y));
+	vertices.append(Vector2(half_size.x, -half_size.y));
+	vertices.append(Vector2(half_size.x, half_size.y));
+	vertices.append(Vector2(-half_size.x, half_size.y));
+
+	PoolVector2Array uvs = PoolVector2Array();
+	uvs.append(Vector2(0.0f, 0.0f));
+	uvs.append(Vector2(1.0f, 0.0f));
+	uvs.append(Vector2(1.0f, 1.0f));
+	uvs.append(Vector2(0.0f, 1.0f));
+
+	PoolIntArray indices = PoolIntArray();
+	indices.append(0);
+	indices.append(1);
+	indices.append(2);
+	indices.append(0);
+	indices.append(2);
+	indices.append(3);
+
+	Array arrays = Array();
+	arrays.resize(VisualServer::ARRAY_MAX);
+	arrays[VisualServer::ARRAY_VERTEX] = vertices;
+	arrays[VisualServer::ARRAY_TEX_UV] = uvs;
+	arrays[VisualServer::ARRAY_INDEX] = indices;
+
+	mesh = server_backend->mesh_create(arrays);
+	multimesh = server_backend->multimesh_create(mesh, pool_size);
+
+	server_backend->canvas_item_add_multimesh(canvas_item, multimesh, texture_rid);
+
+	multimesh_buffer = PoolRealArray();
+	multimesh_buffer.resize(pool_size * MULTIMESH_INSTANCE_SIZE);
+	PoolRealArray::Write write = multimesh_buffer.write();
+	std::fill(write.ptr(), write.ptr() + pool_size * MULTIMESH_INSTANCE_SIZE, 0.0f);
+}
+
+void BulletsPool::_update_multimesh() {
+	if(!multimesh_dirty) {
+		return;
+	}
+	multimesh_dirty = false;
+	{
+		PoolRealArray::Write write = multimesh_buffer.write();
+		real_t* buffer = write.ptr();
+
+		for(int32_t i = 0; i < active_bullets; i++) {
+			const Transform2D& transform = transforms[i];
+			const Color& color = modulates[shape_indices[i] - starting_shape_index];
+			real_t* instance = buffer + i * MULTIMESH_INSTANCE_SIZE;
+
+			// Same layout VisualServer uses for 2D instance transforms, followed by the color.
+			instance[0] = transform.elements[0].x;
+			instance[1] = transform.elements[1].x;
+			instance[2] = 0.0f;
+			instance[3] = transform.elements[2].x;
+			instance[4] = transform.elements[0].y;
+			instance[5] = transform.elements[1].y;
+			instance[6] = 0.0f;
+			instance[7] = transform.elements[2].y;
+			instance[8] = color.r;
+			instance[9] = color.g;
+			instance[10] = color.b;
+			instance[11] = color.a;
+		}
+	}
+	server_backend->multimesh_set_instances(multimesh, multimesh_buffer, active_bullets);
+	stats.server_calls++;
+}
+
+void BulletsPool::_add_to_grid(BulletsGrid& grid) {
+	if(!grid_collisions_enabled) {
+		return;
+	}
+	for(int32_t i = 0; i < active_bullets; i++) {
+		grid.add_bullet(BulletID(shape_indices[i], cycles[i], set_index), grid_layer, grid_shape, transforms[i]);
+	}
+}
+
+void BulletsPool::_add_to_query_grid(BulletsGrid& grid) {
+	for(int32_t i = 0; i < active_bullets; i++) {
+		grid.add_bullet(BulletID(shape_indices[i], cycles[i], set_index), UINT32_MAX, query_shape, transforms[i]);
+	}
+}
+
+int32_t BulletsPool::release_older_than(float lifetime) {
+	for(int32_t i = 0; i < active_bullets; i++) {
+		deaths[i] = lifetimes[i] >= lifetime;
+	}
+	return _release_marked();
+}
+
+int32_t BulletsPool::release_by_predicate(Object* target, const String& method) {
+	for(int32_t i = 0; i < active_bullets; i++) {
+		deaths[i] = (bool)target->call(method, lifetimes[i], data[shape_indices[i] - starting_shape_index]);
+	}
+	return _release_marked();
+}
+
+int32_t BulletsPool::release_in_shape(const BulletsGridShape& shape, const Transform2D& transform) {
+	BulletsGrid::PlacedShape area = BulletsGrid::_place(shape, transform);
+	for(int32_t i = 0; i < active_bullets; i++) {
+		deaths[i] = BulletsGrid::_overlaps(area, BulletsGrid::_place(query_shape, transforms[i]));
+	}
+	return _release_marked();
 }
\ No newline at end of file
@@ -8,30 +8,271 @@
 #include <Material.hpp>
 #include <Color.hpp>
 
+#include <vector>
+#include <utility>
+#include <cstdint>
+
 #include "bullet.h"
 #include "bullet_kit.h"
+#include "bullets_grid.h"
+#include "bullets_server_backend.h"
 
 using namespace godot;
 
 
+// Base class of the additional per-bullet columns a pool can declare.
+template <class BulletType>
+class AbstractBulletsColumn {
+
+public:
+	virtual ~AbstractBulletsColumn() {}
+
+	virtual void resize(int32_t size) = 0;
+	virtual void swap(int32_t a, int32_t b) = 0;
+
+	// Copy the value of a bullet from the column to the proxy object and back.
+	virtual void load(int32_t index, BulletType* proxy) = 0;
+	virtual void store(int32_t index, BulletType* proxy) = 0;
+};
+
+// A contiguous array holding one field of every bullet in a pool.
+// It's bound to the member of the Bullet proxy class that exposes the same field to scripts.
+template <class BulletType, typename T>
+class BulletsColumn : public AbstractBulletsColumn<BulletType> {
+	T BulletType::*member;
+	std::vector<T> values;
+
+public:
+	BulletsColumn(T BulletType::*member): member(member) {}
+
+	inline T& operator[](int32_t index) { return values[index]; }
+	inline const T& operator[](int32_t index) const { return values[index]; }
+	inline T* data() { return values.data(); }
+
+	void resize(int32_t size) override {
+		bool shrinking = size < values.size();
+		values.resize(size);
+		if(shrinking) {
+			values.shrink_to_fit();
+		}
+	}
+	void swap(int32_t a, int32_t b) override { std::swap(values[a], values[b]); }
+
+	void load(int32_t index, BulletType* proxy) override { proxy->*member = values[index]; }
+	void store(int32_t index, BulletType* proxy) override { values[index] = proxy->*member; }
+};
+
+// Counters of a pool over a physics tick, exposed by Bullets.get_frame_stats.
+struct BulletsPoolStats {
+	int64_t simulation_usec = 0;
+	int64_t commit_usec = 0;
+	// Server calls issued by the pool, including the deferred ones.
+	int64_t server_calls = 0;
+	int32_t spawns = 0;
+	int32_t releases = 0;
+	// Bullets released by the simulation, like the ones leaving the active rect.
+	int32_t deaths = 0;
+};
+
+// The areas holding the shapes of a pool, each one holds `shapes_per_area` consecutive shape indices from `first_shape_index`.
+// Shape indices are relative to the whole set, so that they identify bullets whichever area their shape is in.
+struct BulletsPoolAreas {
+	std::vector<RID> areas;
+	int32_t first_shape_index = 0;
+	int32_t shapes_per_area = 0;
+
+	BulletsPoolAreas() {}
+	// A single area holding every shape of the set.
+	BulletsPoolAreas(RID area): areas(1, area), first_shape_index(0), shapes_per_area(INT32_MAX) {}
+
+	// Returns the area holding the shape, and the index of the shape in it.
+	inline RID get_area(int32_t shape_index, int32_t& area_shape_index) const {
+		int32_t shape = shape_index - first_shape_index;
+		area_shape_index = shape % shapes_per_area;
+		return areas[shape / shapes_per_area];
+	}
+};
+
+// Kit settings baked into the server objects of a pool when it's created.
+// A cached pool can only be reused by a kit whose settings didn't change since then.
+struct BulletsPoolKitSettings {
+	RID material;
+	RID collision_shape;
+	bool collisions_enabled = false;
+	int32_t collision_layer = 0;
+	int32_t collision_mask = 0;
+	int32_t collision_backend = 0;
+	int32_t unique_modulate_component = 0;
+	int32_t rendering_mode = 0;
+
+	BulletsPoolKitSettings() {}
+	BulletsPoolKitSettings(const Ref<BulletKit>& kit);
+
+	bool operator==(const BulletsPoolKitSettings& other) const;
+};
+
 class BulletsPool {
-	
+
 protected:
-	int32_t* shapes_to_indices = nullptr;
+	// Maps each shape index, relative to starting_shape_index, to the slot of the bullet using it.
+	std::vector<int32_t> shapes_to_indices;
 	int32_t available_bullets = 0;
 	int32_t active_bullets = 0;
 	int32_t bullets_to_handle = 0;
+	// Whether the bullets have shapes in the shared areas.
 	bool collisions_enabled;
+	// Whether the kit uses static bullets, which are never simulated nor committed.
+	bool static_bullets = false;
+	// Whether the bullets collide through the Bullets grid instead.
+	bool grid_collisions_enabled = false;
+	BulletsGridShape grid_shape;
+	uint32_t grid_layer = 0;
+	// Shape of the bullets in the spatial queries of Bullets, a point if the kit shape is not supported by the grid.
+	BulletsGridShape query_shape;
+	BulletsPoolKitSettings kit_settings;
+	// Reads the grid and query shapes from the kit collision shape.
+	void _read_grid_shapes(const Ref<BulletKit>& kit);
 
 	CanvasLayer* canvas_layer;
 	Viewport* viewport;
 	RID canvas_parent;
+	// Instance ID of the CanvasLayer or World2D owning the canvas, which is freed with it.
+	int64_t canvas_owner_id = 0;
 	RID canvas_item;
-	RID shared_area;
+	BulletsPoolAreas shared_areas;
 	int32_t starting_shape_index;
 
 	Rect2 active_rect;
 
+	// Receives every rendering and physics call of the pool.
+	BulletsServerBackend* server_backend = BulletsServerBackend::get_godot_backend();
+
+	// Counters of the tick in progress, and of the last completed one.
+	BulletsPoolStats stats;
+	BulletsPoolStats frame_stats;
+	// The largest amount of bullets active at the same time.
+	int32_t high_water_mark = 0;
+
+	// Slots with canvas items and per-bullet storage, the others only reserve their shape indices.
+	// Fixed pools allocate every slot in _init, elastic ones start from initial_size and grow by growth_step.
+	int32_t allocated_bullets = 0;
+	int32_t initial_size = 0;
+	int32_t growth_step = 0;
+	// Seconds with at least growth_step unused slots after which an elastic pool shrinks.
+	float shrink_delay = 0.0f;
+	float idle_time = 0.0f;
+	// Cycles of the slots removed by shrinking, indexed like shapes_to_indices, so that old IDs stay invalid.
+	std::vector<int32_t> retired_cycles;
+
+	// Grows an elastic pool, by whole steps, until at least `amount` slots are allocated.
+	inline void _reserve(int32_t amount) {
+		if(amount <= allocated_bullets) {
+			return;
+		}
+		int32_t step = Math::max(growth_step, 1);
+		int32_t steps = (amount - allocated_bullets + step - 1) / step;
+		_reallocate(Math::min(allocated_bullets + steps * step, pool_size));
+	}
+	// Changes the amount of allocated slots, it can only remove free slots holding the highest shape indices.
+	virtual void _reallocate(int32_t amount) = 0;
+
+	template<typename T>
+	void _resize_slots(std::vector<T>& vector, int32_t size) {
+		bool shrinking = size < vector.size();
+		vector.resize(size);
+		if(shrinking) {
+			vector.shrink_to_fit();
+		}
+	}
+
+	// Updates the counters after a bullet is spawned.
+	inline void _count_spawned_bullet() {
+		stats.spawns++;
+		high_water_mark = Math::max(high_water_mark, active_bullets);
+	}
+
+	// Bullets are stored as a structure of arrays, every column is indexed by bullet slot.
+	// Active bullets always occupy the slots [0, active_bullets), free ones the rest of the pool.
+	std::vector<RID> item_rids;
+	std::vector<int32_t> cycles;
+	std::vector<int32_t> shape_indices;
+	std::vector<Transform2D> transforms;
+	// Last transform sent to the servers for each slot, the commit skips the bullets whose transform didn't change.
+	std::vector<Transform2D> committed_transforms;
+	std::vector<Vector2> velocities;
+	std::vector<float> lifetimes;
+	// Never read during processing, indexed like shapes_to_indices so that it doesn't move on release.
+	std::vector<Variant> data;
+	// Written by the simulation phase, a non-zero value marks a bullet to release in the commit phase.
+	// Bytes instead of std::vector<bool>, so that chunks of a pool can be simulated by different threads.
+	std::vector<uint8_t> deaths;
+
+	// When the kit uses the MultiMesh rendering mode, a single MultiMesh replaces the bullets canvas items.
+	bool multimesh_enabled = false;
+	bool multimesh_dirty = false;
+	RID multimesh;
+	RID mesh;
+	// Instances data, uploaded all at once: a 2D transform (8 floats) and a color (4 floats) for each bullet.
+	static const int32_t MULTIMESH_INSTANCE_SIZE = 12;
+	PoolRealArray multimesh_buffer;
+	// Unique modulate color of each bullet, indexed like shapes_to_indices.
+	std::vector<Color> modulates;
+
+	// Texture the draw commands of the canvas items, or the MultiMesh, have been recorded with.
+	// Bullets keep their commands while free, spawns and releases only change their visibility.
+	RID texture_rid;
+	Vector2 texture_size;
+
+	// Rendering calls issued while the pool is processed on a worker thread are recorded here,
+	// then forwarded in order to the backend by the main thread.
+	enum ServerCommandType {
+		SET_ITEM_TRANSFORM,
+		HIDE_ITEM
+	};
+	struct ServerCommand {
+		ServerCommandType type;
+		RID rid;
+		Transform2D transform;
+	};
+	bool deferring_server_commands = false;
+	std::vector<ServerCommand> server_commands;
+
+	// Shape changes are queued, from any thread, and sent by _flush_shape_changes once per tick.
+	// Only the final state of each shape is sent: a bullet spawned and released in the same tick costs no call.
+	enum ShapeFlags {
+		// The state the pool wants, and the one the server has.
+		SHAPE_ENABLED = 1,
+		SHAPE_SERVER_ENABLED = 2,
+		// shape_transforms holds a transform not sent yet, kept until the shape is enabled.
+		SHAPE_TRANSFORM_DIRTY = 4,
+		SHAPE_QUEUED = 8
+	};
+	// Indexed like shapes_to_indices, empty if collisions are disabled.
+	std::vector<uint8_t> shape_flags;
+	std::vector<Transform2D> shape_transforms;
+	std::vector<int32_t> queued_shapes;
+
+	inline void _queue_shape(int32_t offset);
+	// Adds a disabled shape for each shape index of the pool to the shared areas.
+	void _add_shapes(RID shape);
+	// Forgets the state of the shapes, after they have been added to a shared area.
+	void _reset_shapes();
+
+	inline void _set_item_transform(RID item_rid, const Transform2D& transform);
+	inline void _hide_item(RID item_rid);
+	inline void _set_shape_transform(int32_t shape_index, const Transform2D& transform);
+	inline void _set_shape_disabled(int32_t shape_index, bool disabled);
+
+	// Default bullet motion over the slots [begin, end), vectorized: moves the bullets by their velocity,
+	// releases the ones leaving the active rect and increases the lifetime of the others.
+	// Pools whose _process_bullet does only this can use it to implement _simulate.
+	void _integrate_bullets(float delta, int32_t begin, int32_t end);
+	// Releases the active bullets marked in the death mask, returns how many have been released.
+	virtual int32_t _release_marked() = 0;
+
+	void _create_multimesh(Vector2 texture_size, RID texture_rid);
+	inline void _commit_bullet_transform(int32_t index);
+
 	template<typename T>
 	void _swap(T &a, T &b) {
 		T t = a;
@@ -46,17 +287,92 @@ public:
 	BulletsPool();
 	virtual ~BulletsPool();
 
-	virtual void _init(/*RID canvas_parent, Viewport* viewport, */Node* parent_hint, RID shared_area, int32_t starting_shape_index,
+	// Replaces the default backend, which forwards to the engine servers.
+	// Must be called before _init, the backend must outlive the pool.
+	void _set_server_backend(BulletsServerBackend* backend);
+
+	virtual void _init(/*RID canvas_parent, Viewport* viewport, */Node* parent_hint, const BulletsPoolAreas& shared_areas, int32_t starting_shape_index,
 		int32_t set_index, Ref<BulletKit> kit, int32_t pool_size, int32_t z_index) = 0;
-	
+
+	// Moves a pool without active bullets to another shape range of other shared areas, changing its size if needed.
+	// The parent hint must have been updated with _set_parent_hint.
+	virtual void _rebind(const BulletsPoolAreas& shared_areas, int32_t starting_shape_index, int32_t set_index, int32_t pool_size) = 0;
+
+	// Finds the Viewport and the CanvasLayer bullets are drawn in, searching up the scene tree from parent_hint.
+	// Returns the canvas they are drawn on.
+	static RID _find_canvas(Node* parent_hint, Viewport** viewport, CanvasLayer** canvas_layer);
+	// Searches the canvas again from the parent hint of another environment reusing the pool.
+	// Returns false, leaving the pool unchanged, if its bullets would be drawn on a different canvas.
+	bool _set_parent_hint(Node* parent_hint);
+	// Whether the pool could be reused by another environment, without changing it.
+	bool _is_reusable(const Ref<BulletKit>& kit, Node* parent_hint);
+	// Whether the canvas the bullets are drawn on still exists, cached pools are useless without it.
+	bool _is_canvas_valid();
+
 	int32_t get_available_bullets();
 	int32_t get_active_bullets();
+	int32_t get_high_water_mark();
+	int32_t get_allocated_bullets();
 
-	virtual int32_t _process(float delta) = 0;
+	// Makes the pool elastic, must be called before _init. pool_size becomes the hard cap of the pool.
+	void _set_elastic(int32_t initial_size, int32_t growth_step, float shrink_delay);
+	// Shrinks an elastic pool that had unused slots for long enough, must be called on the main thread each tick.
+	void _update_capacity(float delta);
+
+	// Returns the counters of the last completed physics tick.
+	const BulletsPoolStats& get_frame_stats();
+	// Adds the time spent processing the pool, for callers running the phases themselves.
+	void _add_frame_times(int64_t simulation_usec, int64_t commit_usec);
+	// Completes the counters of the current physics tick and starts new ones.
+	void _end_frame_stats();
+
+	// Reads the viewport to update the rect bullets are kept alive in, must be called on the main thread.
+	virtual void _update_active_rect() = 0;
+	// Records the draw commands again if the kit texture changed, must be called on the main thread.
+	virtual void _update_texture() = 0;
+	// Reads any other engine object the simulation depends on, must be called on the main thread before _simulate.
+	virtual void _prepare_simulation();
+	// Processing is split in two phases.
+	// The simulation advances the bullets in the slots [begin, end) and fills the death mask, without calling any server.
+	// Disjoint ranges of the same pool can be simulated at the same time.
+	virtual void _simulate(float delta, int32_t begin, int32_t end) = 0;
+	// The commit pushes the transforms of the surviving bullets, then releases the dead ones all together.
+	// Returns the variation in the amount of active bullets.
+	virtual int32_t _commit() = 0;
+	// Runs both phases over all the active bullets. Static bullets only get older.
+	int32_t _process(float delta);
+	inline bool _has_static_bullets() { return static_bullets; }
+	// Whether _process can run on a worker thread. Pools opt in by returning true, once their processing
+	// doesn't read any other engine object, for example because they resolve them in _prepare_simulation.
+	virtual bool _is_thread_safe();
+
+	// While enabled, server calls are recorded instead of being executed.
+	void _set_deferring_server_commands(bool deferring);
+	// Executes the recorded server calls, must be called on the main thread.
+	void _flush_server_commands();
+	// Sends the queued shape changes to the physics server, must be called on the main thread.
+	void _flush_shape_changes();
+	// Uploads the MultiMesh instances, if they changed since the last call.
+	void _update_multimesh();
+	// Adds the active bullets to the collision grid, if the kit uses it.
+	void _add_to_grid(BulletsGrid& grid);
+	// Adds every active bullet to the grid answering the spatial queries, with a layer matching any mask.
+	void _add_to_query_grid(BulletsGrid& grid);
 
 	virtual void spawn_bullet(Dictionary properties) = 0;
+	// Spawns up to `amount` bullets at once, returns how many have been spawned.
+	// `velocities` and `rotations` can be null, defaulting to zero.
+	virtual int32_t spawn_bullets(const Vector2* positions, const Vector2* velocities, const real_t* rotations, int32_t amount) = 0;
 	virtual BulletID obtain_bullet() = 0;
 	virtual bool release_bullet(BulletID id) = 0;
+	// Releases every active bullet, returns how many have been released.
+	virtual int32_t release_all() = 0;
+	// Release, in a single pass, the bullets at least `lifetime` seconds old, or the ones for which `method` of `target`
+	// returns true when called with their lifetime and data. Bullets refuses spawns and releases while the method runs.
+	int32_t release_older_than(float lifetime);
+	int32_t release_by_predicate(Object* target, const String& method);
+	// Releases, in a single pass, the bullets whose query shape overlaps `shape` placed at `transform`.
+	int32_t release_in_shape(const BulletsGridShape& shape, const Transform2D& transform);
 	virtual bool is_bullet_valid(BulletID id) = 0;
 
 	virtual bool is_bullet_existing(int32_t shape_index) = 0;
@@ -71,27 +387,56 @@ class AbstractBulletsPool : public BulletsPool {
 
 protected:
 	Ref<Kit> kit;
-	BulletType** bullets = nullptr;
+	// Additional columns declared by the pool, registered with _add_column.
+	std::vector<AbstractBulletsColumn<BulletType>*> columns;
+	// Object used to expose a single bullet to scripts, created the first time it's needed.
+	BulletType* proxy = nullptr;
+
+	virtual inline void _init_bullet(int32_t index);
+	virtual inline void _enable_bullet(int32_t index);
+	virtual inline void _disable_bullet(int32_t index);
+	virtual inline bool _process_bullet(int32_t index, float delta);
+	// Called for each bullet spawned by spawn_bullets, after its transform and velocity are set.
+	// Derives the additional columns the Bullet proxy setters would have set.
+	virtual inline void _init_spawned_bullet(int32_t index);
 
-	virtual inline void _init_bullet(BulletType* bullet);
-	virtual inline void _enable_bullet(BulletType* bullet);
-	virtual inline void _disable_bullet(BulletType* bullet);
-	virtual inline bool _process_bullet(BulletType* bullet, float delta);
+	void _add_column(AbstractBulletsColumn<BulletType>* column);
+
+	inline Color _get_unique_modulate(int32_t shape_index);
+	// Creates the canvas items and initializes the slots [begin, end).
+	void _allocate_slots(int32_t begin, int32_t end);
+	virtual void _reallocate(int32_t amount) override;
+
+	// Records the texture rect drawn by a canvas item, once for its whole life.
+	inline void _record_draw_commands(int32_t index);
+	inline void _draw_bullet(int32_t index);
+	inline void _clear_bullet(int32_t index);
 
 	inline void _release_bullet(int32_t index);
+	virtual int32_t _release_marked() override;
+	inline void _swap_bullets(int32_t a, int32_t b);
+
+	BulletType* _load_proxy(int32_t index);
+	void _store_proxy(int32_t index);
 
 public:
 	AbstractBulletsPool() {}
 	virtual ~AbstractBulletsPool();
 
-	virtual void _init(/*RID canvas_parent, Viewport* viewport, */Node* parent_hint, RID shared_area, int32_t starting_shape_index,
+	virtual void _init(/*RID canvas_parent, Viewport* viewport, */Node* parent_hint, const BulletsPoolAreas& shared_areas, int32_t starting_shape_index,
 		int32_t set_index, Ref<BulletKit> kit, int32_t pool_size, int32_t z_index) override;
+	virtual void _rebind(const BulletsPoolAreas& shared_areas, int32_t starting_shape_index, int32_t set_index, int32_t pool_size) override;
 
-	virtual int32_t _process(float delta) override;
+	virtual void _update_active_rect() override;
+	virtual void _update_texture() override;
+	virtual void _simulate(float delta, int32_t begin, int32_t end) override;
+	virtual int32_t _commit() override;
 
 	virtual void spawn_bullet(Dictionary properties) override;
+	virtual int32_t spawn_bullets(const Vector2* positions, const Vector2* velocities, const real_t* rotations, int32_t amount) override;
 	virtual BulletID obtain_bullet() override;
 	virtual bool release_bullet(BulletID id) override;
+	virtual int32_t release_all() override;
 	virtual bool is_bullet_valid(BulletID id) override;
 
 	virtual bool is_bullet_existing(int32_t shape_index) override;
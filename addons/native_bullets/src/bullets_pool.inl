@@ -1,7 +1,5 @@
 #include <Godot.hpp>
-#include <VisualServer.hpp>
 #include <World2D.hpp>
-#include <Physics2DServer.hpp>
 #include <Viewport.hpp>
 #include <Font.hpp>
 
@@ -13,139 +11,351 @@ using namespace godot;
 //-- START Default "standard" implementations.
 
 template <class Kit, class BulletType>
-void AbstractBulletsPool<Kit, BulletType>::_init_bullet(BulletType* bullet) {}
+void AbstractBulletsPool<Kit, BulletType>::_init_bullet(int32_t index) {}
 
 template <class Kit, class BulletType>
-void AbstractBulletsPool<Kit, BulletType>::_enable_bullet(BulletType* bullet) {
-	bullet->lifetime = 0.0f;
-
-	Rect2 texture_rect = Rect2(-kit->texture->get_size() / 2.0f, kit->texture->get_size());
-	RID texture_rid = kit->texture->get_rid();
-	
-	VisualServer::get_singleton()->canvas_item_add_texture_rect(bullet->item_rid,
-		texture_rect,
-		texture_rid);
+void AbstractBulletsPool<Kit, BulletType>::_enable_bullet(int32_t index) {
+	lifetimes[index] = 0.0f;
 }
 
 template <class Kit, class BulletType>
-void AbstractBulletsPool<Kit, BulletType>::_disable_bullet(BulletType* bullet) {
-	VisualServer::get_singleton()->canvas_item_clear(bullet->item_rid);
-}
+void AbstractBulletsPool<Kit, BulletType>::_disable_bullet(int32_t index) {}
 
 template <class Kit, class BulletType>
-bool AbstractBulletsPool<Kit, BulletType>::_process_bullet(BulletType* bullet, float delta) {
-	bullet->transform.set_origin(bullet->transform.get_origin() + bullet->velocity * delta);
+bool AbstractBulletsPool<Kit, BulletType>::_process_bullet(int32_t index, float delta) {
+	Transform2D& transform = transforms[index];
+	transform.set_origin(transform.get_origin() + velocities[index] * delta);
 
-	if(!active_rect.has_point(bullet->transform.get_origin())) {
+	if(!active_rect.has_point(transform.get_origin())) {
 		return true;
 	}
 
-	bullet->lifetime += delta;
+	lifetimes[index] += delta;
 	return false;
 }
 
+template <class Kit, class BulletType>
+void AbstractBulletsPool<Kit, BulletType>::_init_spawned_bullet(int32_t index) {}
+
 //-- END Default "standard" implementation.
 
+void BulletsPool::_set_item_transform(RID item_rid, const Transform2D& transform) {
+	stats.server_calls++;
+	if(deferring_server_commands) {
+		server_commands.push_back({ SET_ITEM_TRANSFORM, item_rid, transform });
+		return;
+	}
+	server_backend->canvas_item_set_transform(item_rid, transform);
+}
+
+void BulletsPool::_hide_item(RID item_rid) {
+	stats.server_calls++;
+	if(deferring_server_commands) {
+		server_commands.push_back({ HIDE_ITEM, item_rid, Transform2D() });
+		return;
+	}
+	server_backend->canvas_item_set_visible(item_rid, false);
+}
+
+void BulletsPool::_queue_shape(int32_t offset) {
+	if(!(shape_flags[offset] & SHAPE_QUEUED)) {
+		shape_flags[offset] |= SHAPE_QUEUED;
+		queued_shapes.push_back(offset);
+	}
+}
+
+void BulletsPool::_set_shape_transform(int32_t shape_index, const Transform2D& transform) {
+	int32_t offset = shape_index - starting_shape_index;
+	shape_transforms[offset] = transform;
+	shape_flags[offset] |= SHAPE_TRANSFORM_DIRTY;
+	_queue_shape(offset);
+}
+
+void BulletsPool::_set_shape_disabled(int32_t shape_index, bool disabled) {
+	int32_t offset = shape_index - starting_shape_index;
+	if(disabled) {
+		shape_flags[offset] &= ~SHAPE_ENABLED;
+	} else {
+		shape_flags[offset] |= SHAPE_ENABLED;
+	}
+	_queue_shape(offset);
+}
+
+void BulletsPool::_commit_bullet_transform(int32_t index) {
+	committed_transforms[index] = transforms[index];
+	if(multimesh_enabled) {
+		multimesh_dirty = true;
+	} else {
+		_set_item_transform(item_rids[index], transforms[index]);
+	}
+	if(collisions_enabled)
+		_set_shape_transform(shape_indices[index], transforms[index]);
+}
+
+template <class Kit, class BulletType>
+void AbstractBulletsPool<Kit, BulletType>::_record_draw_commands(int32_t index) {
+	// Configure the bullet to draw the kit texture each frame it's visible.
+	server_backend->canvas_item_add_texture_rect(item_rids[index],
+		Rect2(-texture_size / 2.0f, texture_size),
+		texture_rid);
+}
+
+template <class Kit, class BulletType>
+void AbstractBulletsPool<Kit, BulletType>::_draw_bullet(int32_t index) {
+	if(multimesh_enabled) {
+		// Active instances are drawn automatically.
+		multimesh_dirty = true;
+		return;
+	}
+	server_backend->canvas_item_set_visible(item_rids[index], true);
+	stats.server_calls++;
+}
+
+template <class Kit, class BulletType>
+void AbstractBulletsPool<Kit, BulletType>::_clear_bullet(int32_t index) {
+	if(multimesh_enabled) {
+		multimesh_dirty = true;
+		return;
+	}
+	_hide_item(item_rids[index]);
+}
+
 template <class Kit, class BulletType>
 AbstractBulletsPool<Kit, BulletType>::~AbstractBulletsPool() {
 	// Bullets node is responsible for clearing all the area and area shapes
-	for(int32_t i = 0; i < pool_size; i++) {
-		VisualServer::get_singleton()->free_rid(bullets[i]->item_rid);
-		bullets[i]->free();
+	if(multimesh_enabled) {
+		server_backend->free_rid(multimesh);
+		server_backend->free_rid(mesh);
+	} else {
+		for(int32_t i = 0; i < allocated_bullets; i++) {
+			server_backend->free_rid(item_rids[i]);
+		}
 	}
-	VisualServer::get_singleton()->free_rid(canvas_item);
+	server_backend->free_rid(canvas_item);
 
-	delete[] bullets;
-	delete[] shapes_to_indices;
+	if(proxy != nullptr) {
+		proxy->free();
+	}
+}
+
+template <class Kit, class BulletType>
+void AbstractBulletsPool<Kit, BulletType>::_add_column(AbstractBulletsColumn<BulletType>* column) {
+	columns.push_back(column);
 }
 
 template <class Kit, class BulletType>
-void AbstractBulletsPool<Kit, BulletType>::_init(Node* parent_hint, RID shared_area, int32_t starting_shape_index,
+void AbstractBulletsPool<Kit, BulletType>::_init(Node* parent_hint, const BulletsPoolAreas& shared_areas, int32_t starting_shape_index,
 		int32_t set_index, Ref<BulletKit> kit, int32_t pool_size, int32_t z_index) {
-	
-	// Check if collisions are enabled and if layer or mask are != 0, 
+
+	// Check if collisions are enabled and if layer or mask are != 0,
 	// otherwise the bullets would not collide with anything anyways.
-	this->collisions_enabled = kit->collisions_enabled && kit->collision_shape.is_valid() &&
+	bool collidable = kit->collisions_enabled && kit->collision_shape.is_valid() &&
 		((int64_t)kit->collision_layer + (int64_t)kit->collision_mask) != 0;
+	this->grid_collisions_enabled = collidable && kit->collision_backend == 1;
+	_read_grid_shapes(kit);
+	this->grid_layer = kit->collision_layer;
+	this->kit_settings = BulletsPoolKitSettings(kit);
+	this->collisions_enabled = collidable && !grid_collisions_enabled && kit->collision_backend == 0;
 	// this->viewport = viewport;
-	this->shared_area = shared_area;
+	this->shared_areas = shared_areas;
 	this->starting_shape_index = starting_shape_index;
 	this->kit = kit;
 	this->pool_size = pool_size;
 	this->set_index = set_index;
+	this->multimesh_enabled = kit->rendering_mode == 1;
+	this->static_bullets = kit->static_bullets;
 
-	this->viewport = nullptr;
-	this->canvas_layer = nullptr;
+	this->canvas_parent = _find_canvas(parent_hint, &this->viewport, &this->canvas_layer);
+	this->canvas_owner_id = canvas_layer != nullptr ? canvas_layer->get_instance_id() : viewport->find_world_2d()->get_instance_id();
+	this->texture_rid = this->kit->texture->get_rid();
+	this->texture_size = this->kit->texture->get_size();
 
-	Node* n = parent_hint;
-	while (n) {
-		if (!this->canvas_layer) {
-			this->canvas_layer = Object::cast_to<CanvasLayer>(n);
-		}
-		this->viewport = Object::cast_to<Viewport>(n);
-		if (this->viewport) {
-			break;
-		}
-		
-		n = n->get_parent();
+	available_bullets = pool_size;
+	active_bullets = 0;
+
+	canvas_item = server_backend->canvas_item_create(canvas_parent);
+	server_backend->canvas_item_set_z_index(canvas_item, z_index);
+
+	if(multimesh_enabled) {
+		// The whole pool is drawn by its canvas item.
+		// The MultiMesh has room for the whole pool, elastic pools only grow the instances drawn.
+		server_backend->canvas_item_set_material(canvas_item, kit->material->get_rid());
+		_create_multimesh(texture_size, texture_rid);
+	}
+	if(collisions_enabled) {
+		// Shapes are indexed by their position in the shared areas, so every shape index of the pool is added up front.
+		// They stay disabled until used.
+		_add_shapes(kit->collision_shape->get_rid());
 	}
-	if (this->canvas_layer) {
-		this->canvas_parent = canvas_layer->get_canvas();
+
+	// Shape indices above the allocated slots map to an invalid slot.
+	shapes_to_indices.assign(pool_size, pool_size);
+	_reset_shapes();
+	if(growth_step > 0) {
+		retired_cycles.assign(pool_size, 0);
+		_reallocate(Math::min(initial_size, pool_size));
 	} else {
-		this->canvas_parent = viewport->find_world_2d()->get_canvas();
+		_reallocate(pool_size);
 	}
+}
 
-	available_bullets = pool_size;
-	active_bullets = 0;
+template <class Kit, class BulletType>
+void AbstractBulletsPool<Kit, BulletType>::_rebind(const BulletsPoolAreas& shared_areas, int32_t starting_shape_index, int32_t set_index, int32_t pool_size) {
+	// Shape indices move with the range, slots and shapes_to_indices are relative to it and stay the same.
+	int32_t shape_index_offset = starting_shape_index - this->starting_shape_index;
+	for(int32_t i = 0; i < allocated_bullets; i++) {
+		shape_indices[i] += shape_index_offset;
+	}
+	this->shared_areas = shared_areas;
+	this->starting_shape_index = starting_shape_index;
+	this->set_index = set_index;
+	this->static_bullets = kit->static_bullets;
+	// The collision shape resource could have been edited while the pool was cached, the physics server follows it already.
+	_read_grid_shapes(kit);
+
+	if(shape_index_offset != 0 && kit->unique_modulate_component != 0) {
+		for(int32_t i = 0; i < allocated_bullets; i++) {
+			Color color = _get_unique_modulate(shape_indices[i]);
+			if(multimesh_enabled) {
+				modulates[shape_indices[i] - starting_shape_index] = color;
+			} else {
+				server_backend->canvas_item_set_modulate(item_rids[i], color);
+			}
+		}
+	}
 
-	bullets = new BulletType*[pool_size];
-	shapes_to_indices = new int32_t[pool_size];
+	if(pool_size != this->pool_size) {
+		// Keep the cycles of the slots removed from fixed pools too, they could be allocated again later.
+		retired_cycles.resize(Math::max(this->pool_size, pool_size), 0);
+
+		int32_t amount = growth_step > 0 ? Math::min(allocated_bullets, pool_size) : pool_size;
+		if(amount < allocated_bullets) {
+			_reallocate(amount);
+		}
+		shapes_to_indices.resize(pool_size);
+		for(int32_t i = allocated_bullets; i < pool_size; i++) {
+			shapes_to_indices[i] = pool_size;
+		}
+		retired_cycles.resize(pool_size);
+		this->pool_size = pool_size;
+		available_bullets = pool_size;
+		if(amount > allocated_bullets) {
+			_reallocate(amount);
+		}
 
-	canvas_item = VisualServer::get_singleton()->canvas_item_create();
-	VisualServer::get_singleton()->canvas_item_set_parent(canvas_item, canvas_parent);
-	VisualServer::get_singleton()->canvas_item_set_z_index(canvas_item, z_index);
+		if(multimesh_enabled) {
+			server_backend->canvas_item_clear(canvas_item);
+			server_backend->free_rid(multimesh);
+			server_backend->free_rid(mesh);
+			_create_multimesh(texture_size, texture_rid);
+		}
+	}
+	// The kit texture could have changed while the pool was cached.
+	_update_texture();
 
-	for(int32_t i = 0; i < pool_size; i++) {
-		BulletType* bullet = BulletType::_new();
-		bullets[i] = bullet;
+	if(collisions_enabled) {
+		_add_shapes(kit->collision_shape->get_rid());
+		// The new shapes don't have the transforms of the canvas items, send them when the bullets are enabled.
+		_reset_shapes();
+		for(int32_t i = 0; i < allocated_bullets; i++) {
+			int32_t offset = shape_indices[i] - starting_shape_index;
+			shape_transforms[offset] = committed_transforms[i];
+			shape_flags[offset] = SHAPE_TRANSFORM_DIRTY;
+		}
+	}
+}
 
-		bullet->item_rid = VisualServer::get_singleton()->canvas_item_create();
-		VisualServer::get_singleton()->canvas_item_set_parent(bullet->item_rid, canvas_item);
-		VisualServer::get_singleton()->canvas_item_set_material(bullet->item_rid, kit->material->get_rid());
+template <class Kit, class BulletType>
+void AbstractBulletsPool<Kit, BulletType>::_allocate_slots(int32_t begin, int32_t end) {
+	for(int32_t i = begin; i < end; i++) {
+		if(!multimesh_enabled) {
+			item_rids[i] = server_backend->canvas_item_create(canvas_item);
+			server_backend->canvas_item_set_material(item_rids[i], kit->material->get_rid());
+			// Free bullets are hidden rather than cleared.
+			_record_draw_commands(i);
+			server_backend->canvas_item_set_visible(item_rids[i], false);
+		}
 
-		if(collisions_enabled) {
-			RID shared_shape_rid = kit->collision_shape->get_rid();
+		// The shape index identifies the bullet even when collisions are disabled.
+		shape_indices[i] = starting_shape_index + i;
+		shapes_to_indices[i] = i;
+		cycles[i] = retired_cycles.empty() ? 0 : retired_cycles[i];
 
-			Physics2DServer::get_singleton()->area_add_shape(shared_area, shared_shape_rid, Transform2D(), true);
-			bullet->shape_index = starting_shape_index + i;
-			shapes_to_indices[i] = i;
+		Color color = _get_unique_modulate(starting_shape_index + i);
+		if(multimesh_enabled) {
+			modulates[i] = color;
+		} else {
+			server_backend->canvas_item_set_modulate(item_rids[i], color);
 		}
 
-		Color color = Color(1.0f, 1.0f, 1.0f, 1.0f);
-		switch(kit->unique_modulate_component) {
-			case 1: // Red
-				color.r = fmod((starting_shape_index + i) * 0.7213f, 1.0f);
-				break;
-			case 2: // Green
-				color.g = fmod((starting_shape_index + i) * 0.7213f, 1.0f);
-				break;
-			case 3: // Blue
-				color.b = fmod((starting_shape_index + i) * 0.7213f, 1.0f);
-				break;
-			case 4: // Alpha
-				color.a = fmod((starting_shape_index + i) * 0.7213f, 1.0f);
-				break;
-			default: // None or other values
-				break;
+		_init_bullet(i);
+	}
+}
+
+template <class Kit, class BulletType>
+Color AbstractBulletsPool<Kit, BulletType>::_get_unique_modulate(int32_t shape_index) {
+	Color color = Color(1.0f, 1.0f, 1.0f, 1.0f);
+	switch(kit->unique_modulate_component) {
+		case 1: // Red
+			color.r = fmod(shape_index * 0.7213f, 1.0f);
+			break;
+		case 2: // Green
+			color.g = fmod(shape_index * 0.7213f, 1.0f);
+			break;
+		case 3: // Blue
+			color.b = fmod(shape_index * 0.7213f, 1.0f);
+			break;
+		case 4: // Alpha
+			color.a = fmod(shape_index * 0.7213f, 1.0f);
+			break;
+		default: // None or other values
+			break;
+	}
+	return color;
+}
+
+template <class Kit, class BulletType>
+void AbstractBulletsPool<Kit, BulletType>::_reallocate(int32_t amount) {
+	int32_t previous_amount = allocated_bullets;
+
+	if(amount < previous_amount) {
+		// Move the removed shape indices to the last slots, all of them belong to free bullets.
+		for(int32_t i = amount; i < previous_amount; i++) {
+			_swap_bullets(shapes_to_indices[i], i);
 		}
-		VisualServer::get_singleton()->canvas_item_set_modulate(bullet->item_rid, color);
+		for(int32_t i = amount; i < previous_amount; i++) {
+			retired_cycles[i] = cycles[i];
+			shapes_to_indices[i] = pool_size;
+			if(!multimesh_enabled) {
+				server_backend->free_rid(item_rids[i]);
+			}
+		}
+	}
+	allocated_bullets = amount;
+
+	_resize_slots(item_rids, amount);
+	_resize_slots(cycles, amount);
+	_resize_slots(shape_indices, amount);
+	_resize_slots(transforms, amount);
+	_resize_slots(committed_transforms, amount);
+	_resize_slots(velocities, amount);
+	_resize_slots(lifetimes, amount);
+	_resize_slots(data, amount);
+	_resize_slots(deaths, amount);
+	if(multimesh_enabled) {
+		_resize_slots(modulates, amount);
+	}
+	for(int32_t i = 0; i < columns.size(); i++) {
+		columns[i]->resize(amount);
+	}
 
-		_init_bullet(bullet);
+	if(amount > previous_amount) {
+		_allocate_slots(previous_amount, amount);
 	}
 }
 
 template <class Kit, class BulletType>
-int32_t AbstractBulletsPool<Kit, BulletType>::_process(float delta) {
+void AbstractBulletsPool<Kit, BulletType>::_update_active_rect() {
 	if(kit->use_viewport_as_active_rect) {
 		Rect2 viewport_rect = viewport->get_visible_rect();
 		Transform2D viewport_inv_transform = canvas_layer ? canvas_layer->get_transform().affine_inverse() : viewport->get_canvas_transform().affine_inverse();
@@ -163,77 +373,122 @@ int32_t AbstractBulletsPool<Kit, BulletType>::_process(float delta) {
 	} else {
 		active_rect = kit->active_rect;
 	}
-	int32_t amount_variation = 0;
+}
 
-	if(collisions_enabled) {
-		for(int32_t i = pool_size - 1; i >= available_bullets; i--) {
-			BulletType* bullet = bullets[i];
-
-			if(_process_bullet(bullet, delta)) {
-				_release_bullet(i);
-				amount_variation -= 1;
-				i += 1;
-				continue;
-			}
-			
-			VisualServer::get_singleton()->canvas_item_set_transform(bullet->item_rid, bullet->transform);
-			Physics2DServer::get_singleton()->area_set_shape_transform(shared_area, bullet->shape_index, bullet->transform);
-		}
+template <class Kit, class BulletType>
+void AbstractBulletsPool<Kit, BulletType>::_update_texture() {
+	RID rid = kit->texture->get_rid();
+	Vector2 size = kit->texture->get_size();
+	if(rid == texture_rid && size == texture_size) {
+		return;
+	}
+	texture_rid = rid;
+	texture_size = size;
+
+	if(multimesh_enabled) {
+		server_backend->canvas_item_clear(canvas_item);
+		server_backend->free_rid(multimesh);
+		server_backend->free_rid(mesh);
+		_create_multimesh(texture_size, texture_rid);
+		multimesh_dirty = true;
 	} else {
-		for(int32_t i = pool_size - 1; i >= available_bullets; i--) {
-			BulletType* bullet = bullets[i];
-
-			if(_process_bullet(bullet, delta)) {
-				_release_bullet(i);
-				amount_variation -= 1;
-				i += 1;
-				continue;
-			}
-			
-			VisualServer::get_singleton()->canvas_item_set_transform(bullet->item_rid, bullet->transform);
+		for(int32_t i = 0; i < allocated_bullets; i++) {
+			server_backend->canvas_item_clear(item_rids[i]);
+			_record_draw_commands(i);
 		}
 	}
-	return amount_variation;
+}
+
+template <class Kit, class BulletType>
+void AbstractBulletsPool<Kit, BulletType>::_simulate(float delta, int32_t begin, int32_t end) {
+	for(int32_t i = begin; i < end; i++) {
+		deaths[i] = _process_bullet(i, delta);
+	}
+}
+
+template <class Kit, class BulletType>
+int32_t AbstractBulletsPool<Kit, BulletType>::_commit() {
+	// Push the transforms before releasing, releases move bullets around.
+	// Bullets that didn't move since their last commit, like parked ones, are skipped.
+	for(int32_t i = 0; i < active_bullets; i++) {
+		if(!deaths[i] && transforms[i] != committed_transforms[i]) {
+			_commit_bullet_transform(i);
+		}
+	}
+	int32_t released = _release_marked();
+	stats.deaths += released;
+	return -released;
 }
 
 template <class Kit, class BulletType>
 void AbstractBulletsPool<Kit, BulletType>::spawn_bullet(Dictionary properties) {
 	if(available_bullets > 0) {
+		_reserve(active_bullets + 1);
+		int32_t index = active_bullets;
 		available_bullets -= 1;
 		active_bullets += 1;
 
-		BulletType* bullet = bullets[available_bullets];
-
 		if(collisions_enabled)
-			Physics2DServer::get_singleton()->area_set_shape_disabled(shared_area, bullet->shape_index, false);
+			_set_shape_disabled(shape_indices[index], false);
 
+		BulletType* bullet = _load_proxy(index);
 		Array keys = properties.keys();
 		for(int32_t i = 0; i < keys.size(); i++) {
 			bullet->set(keys[i], properties[keys[i]]);
 		}
+		_store_proxy(index);
+
+		_commit_bullet_transform(index);
+
+		_draw_bullet(index);
+		_enable_bullet(index);
+		_count_spawned_bullet();
+	}
+}
+
+template <class Kit, class BulletType>
+int32_t AbstractBulletsPool<Kit, BulletType>::spawn_bullets(const Vector2* positions, const Vector2* velocities,
+		const real_t* rotations, int32_t amount) {
+	amount = Math::min(amount, available_bullets);
+	_reserve(active_bullets + amount);
+
+	for(int32_t i = 0; i < amount; i++) {
+		int32_t index = active_bullets;
+		available_bullets -= 1;
+		active_bullets += 1;
 
-		VisualServer::get_singleton()->canvas_item_set_transform(bullet->item_rid, bullet->transform);
 		if(collisions_enabled)
-			Physics2DServer::get_singleton()->area_set_shape_transform(shared_area, bullet->shape_index, bullet->transform);
+			_set_shape_disabled(shape_indices[index], false);
+
+		transforms[index] = Transform2D(rotations != nullptr ? rotations[i] : 0.0f, positions[i]);
+		this->velocities[index] = velocities != nullptr ? velocities[i] : Vector2();
+		_init_spawned_bullet(index);
+
+		_commit_bullet_transform(index);
 
-		_enable_bullet(bullet);
+		_draw_bullet(index);
+		_enable_bullet(index);
+		_count_spawned_bullet();
 	}
+	return amount;
 }
 
 template <class Kit, class BulletType>
 BulletID AbstractBulletsPool<Kit, BulletType>::obtain_bullet() {
 	if(available_bullets > 0) {
+		_reserve(active_bullets + 1);
+		int32_t index = active_bullets;
 		available_bullets -= 1;
 		active_bullets += 1;
 
-		BulletType* bullet = bullets[available_bullets];
-
 		if(collisions_enabled)
-			Physics2DServer::get_singleton()->area_set_shape_disabled(shared_area, bullet->shape_index, false);
+			_set_shape_disabled(shape_indices[index], false);
 
-		_enable_bullet(bullet);
+		_draw_bullet(index);
+		_enable_bullet(index);
+		_count_spawned_bullet();
 
-		return BulletID(bullet->shape_index, bullet->cycle, set_index);
+		return BulletID(shape_indices[index], cycles[index], set_index);
 	}
 	return BulletID(-1, -1, -1);
 }
@@ -242,7 +497,7 @@ template <class Kit, class BulletType>
 bool AbstractBulletsPool<Kit, BulletType>::release_bullet(BulletID id) {
 	if(id.index >= starting_shape_index && id.index < starting_shape_index + pool_size && id.set == set_index) {
 		int32_t bullet_index = shapes_to_indices[id.index - starting_shape_index];
-		if(bullet_index >= available_bullets && bullet_index < pool_size && id.cycle == bullets[bullet_index]->cycle) {
+		if(bullet_index < active_bullets && id.cycle == cycles[bullet_index]) {
 			_release_bullet(bullet_index);
 			return true;
 		}
@@ -250,28 +505,102 @@ bool AbstractBulletsPool<Kit, BulletType>::release_bullet(BulletID id) {
 	return false;
 }
 
+template <class Kit, class BulletType>
+int32_t AbstractBulletsPool<Kit, BulletType>::release_all() {
+	int32_t amount = active_bullets;
+	// Always release the last active bullet, so that nothing has to be swapped.
+	for(int32_t i = active_bullets - 1; i >= 0; i--) {
+		_release_bullet(i);
+	}
+	return amount;
+}
+
 template <class Kit, class BulletType>
 void AbstractBulletsPool<Kit, BulletType>::_release_bullet(int32_t index) {
-	BulletType* bullet = bullets[index];
-	
 	if(collisions_enabled)
-		Physics2DServer::get_singleton()->area_set_shape_disabled(shared_area, bullet->shape_index, true);
-	
-	_disable_bullet(bullet);
-	bullet->cycle += 1;
+		_set_shape_disabled(shape_indices[index], true);
 
-	_swap(shapes_to_indices[bullet->shape_index - starting_shape_index], shapes_to_indices[bullets[available_bullets]->shape_index - starting_shape_index]);
-	_swap(bullets[index], bullets[available_bullets]);
+	_disable_bullet(index);
+	_clear_bullet(index);
+	cycles[index] += 1;
+
+	// Keep active bullets packed at the beginning of the columns.
+	_swap_bullets(index, active_bullets - 1);
 
 	available_bullets += 1;
 	active_bullets -= 1;
+	stats.releases++;
+}
+
+template <class Kit, class BulletType>
+int32_t AbstractBulletsPool<Kit, BulletType>::_release_marked() {
+	int32_t released = 0;
+	// Iterate backwards, a released bullet is swapped with the last active one, which is always alive by then.
+	for(int32_t i = active_bullets - 1; i >= 0; i--) {
+		if(deaths[i]) {
+			_release_bullet(i);
+			released += 1;
+		}
+	}
+	return released;
+}
+
+template <class Kit, class BulletType>
+void AbstractBulletsPool<Kit, BulletType>::_swap_bullets(int32_t a, int32_t b) {
+	if(a == b) {
+		return;
+	}
+	_swap(shapes_to_indices[shape_indices[a] - starting_shape_index], shapes_to_indices[shape_indices[b] - starting_shape_index]);
+
+	_swap(item_rids[a], item_rids[b]);
+	_swap(cycles[a], cycles[b]);
+	_swap(shape_indices[a], shape_indices[b]);
+	_swap(transforms[a], transforms[b]);
+	_swap(committed_transforms[a], committed_transforms[b]);
+	_swap(velocities[a], velocities[b]);
+	_swap(lifetimes[a], lifetimes[b]);
+	for(int32_t i = 0; i < columns.size(); i++) {
+		columns[i]->swap(a, b);
+	}
+}
+
+template <class Kit, class BulletType>
+BulletType* AbstractBulletsPool<Kit, BulletType>::_load_proxy(int32_t index) {
+	if(proxy == nullptr) {
+		proxy = BulletType::_new();
+	}
+	proxy->item_rid = item_rids[index];
+	proxy->cycle = cycles[index];
+	proxy->shape_index = shape_indices[index];
+	proxy->transform = transforms[index];
+	proxy->velocity = velocities[index];
+	proxy->lifetime = lifetimes[index];
+	proxy->data = data[shape_indices[index] - starting_shape_index];
+	for(int32_t i = 0; i < columns.size(); i++) {
+		columns[i]->load(index, proxy);
+	}
+	return proxy;
+}
+
+template <class Kit, class BulletType>
+void AbstractBulletsPool<Kit, BulletType>::_store_proxy(int32_t index) {
+	// item_rid, cycle and shape_index are read-only.
+	transforms[index] = proxy->transform;
+	velocities[index] = proxy->velocity;
+	lifetimes[index] = proxy->lifetime;
+	data[shape_indices[index] - starting_shape_index] = proxy->data;
+	for(int32_t i = 0; i < columns.size(); i++) {
+		columns[i]->store(index, proxy);
+	}
+	// Don't keep a reference to the data around.
+	proxy->data = Variant();
 }
 
 template <class Kit, class BulletType>
 bool AbstractBulletsPool<Kit, BulletType>::is_bullet_valid(BulletID id) {
 	if(id.index >= starting_shape_index && id.index < starting_shape_index + pool_size && id.set == set_index) {
 		int32_t bullet_index = shapes_to_indices[id.index - starting_shape_index];
-		if(bullet_index >= available_bullets && bullet_index < pool_size && id.cycle == bullets[bullet_index]->cycle) {
+		if(bullet_index < active_bullets && id.cycle == cycles[bullet_index]) {
 			return true;
 		}
 	}
@@ -282,7 +611,7 @@ template <class Kit, class BulletType>
 bool AbstractBulletsPool<Kit, BulletType>::is_bullet_existing(int32_t shape_index) {
 	if(shape_index >= starting_shape_index && shape_index < starting_shape_index + pool_size) {
 		int32_t bullet_index = shapes_to_indices[shape_index - starting_shape_index];
-		if(bullet_index >= available_bullets) {
+		if(bullet_index < active_bullets) {
 			return true;
 		}
 	}
@@ -293,8 +622,8 @@ template <class Kit, class BulletType>
 BulletID AbstractBulletsPool<Kit, BulletType>::get_bullet_from_shape(int32_t shape_index) {
 	if(shape_index >= starting_shape_index && shape_index < starting_shape_index + pool_size) {
 		int32_t bullet_index = shapes_to_indices[shape_index - starting_shape_index];
-		if(bullet_index >= available_bullets) {
-			return BulletID(shape_index, bullets[bullet_index]->cycle, set_index);
+		if(bullet_index < active_bullets) {
+			return BulletID(shape_index, cycles[bullet_index], set_index);
 		}
 	}
 	return BulletID(-1, -1, -1);
@@ -305,13 +634,12 @@ template <class Kit, class BulletType>
 void AbstractBulletsPool<Kit, BulletType>::set_bullet_property(BulletID id, String property, Variant value) {
 	if(is_bullet_valid(id)) {
 		int32_t bullet_index = shapes_to_indices[id.index - starting_shape_index];
-		bullets[bullet_index]->set(property, value);
+		// Go through the proxy, kits can define custom setters.
+		_load_proxy(bullet_index)->set(property, value);
+		_store_proxy(bullet_index);
 
 		if(property == "transform") {
-			BulletType* bullet = bullets[bullet_index];
-			VisualServer::get_singleton()->canvas_item_set_transform(bullet->item_rid, bullet->transform);
-			if(collisions_enabled)
-				Physics2DServer::get_singleton()->area_set_shape_transform(shared_area, bullet->shape_index, bullet->transform);
+			_commit_bullet_transform(bullet_index);
 		}
 	}
 }
@@ -321,7 +649,19 @@ Variant AbstractBulletsPool<Kit, BulletType>::get_bullet_property(BulletID id, S
 	if(is_bullet_valid(id)) {
 		int32_t bullet_index = shapes_to_indices[id.index - starting_shape_index];
 
-		return bullets[bullet_index]->get(property);
+		// Common properties are read straight from the columns.
+		if(property == "transform") {
+			return transforms[bullet_index];
+		} else if(property == "velocity") {
+			return velocities[bullet_index];
+		} else if(property == "lifetime") {
+			return lifetimes[bullet_index];
+		} else if(property == "data") {
+			return data[id.index - starting_shape_index];
+		}
+		Variant result = _load_proxy(bullet_index)->get(property);
+		proxy->data = Variant();
+		return result;
 	}
 	return Variant();
 }
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include "bullets_scheduler.h"
+#include "bullets_emitter.h"
+
+using namespace godot;
+
+
+int64_t BulletsScheduler::schedule(Object* target, String method, float delay, float interval) {
+	if(target == nullptr) {
+		return 0;
+	}
+	Event event;
+	event.id = next_id++;
+	event.instance_id = target->get_instance_id();
+	// Emitters are shot without going through the scripting API.
+	event.emitter = method == "shoot" ? Object::cast_to<BulletsEmitter>(target) : nullptr;
+	event.method = method;
+	event.remaining_time = Math::max(delay, 0.0f);
+	event.interval = Math::max(interval, 0.0f);
+	event.done = false;
+
+	events_indices[event.id] = events.size();
+	events.push_back(event);
+	return event.id;
+}
+
+void BulletsScheduler::_remove_at(int32_t index) {
+	events_indices.erase(events[index].id);
+	if(index != events.size() - 1) {
+		events[index] = events.back();
+		events_indices[events[index].id] = index;
+	}
+	events.pop_back();
+}
+
+bool BulletsScheduler::cancel(int64_t id) {
+	auto found = events_indices.find(id);
+	if(found == events_indices.end()) {
+		return false;
+	}
+	_remove_at(found->second);
+	return true;
+}
+
+bool BulletsScheduler::set_interval(int64_t id, float interval) {
+	auto found = events_indices.find(id);
+	if(found == events_indices.end()) {
+		return false;
+	}
+	events[found->second].interval = Math::max(interval, 0.0f);
+	return true;
+}
+
+bool BulletsScheduler::is_scheduled(int64_t id) {
+	auto found = events_indices.find(id);
+	return found != events_indices.end() && !events[found->second].done;
+}
+
+void BulletsScheduler::clear() {
+	events.clear();
+	events_indices.clear();
+}
+
+int32_t BulletsScheduler::get_events_amount() {
+	return events.size();
+}
+
+void BulletsScheduler::process(float delta) {
+	// Advance every event first, then call the targets, whose calls can add and remove events.
+	firings.clear();
+	for(int32_t i = 0; i < events.size(); i++) {
+		Event& event = events[i];
+		event.remaining_time -= delta;
+		while(!event.done && event.remaining_time <= 0.0f) {
+			firings.push_back({ event.id, -event.remaining_time });
+			if(event.interval > 0.0f) {
+				event.remaining_time += event.interval;
+			} else {
+				event.done = true;
+			}
+		}
+	}
+
+	for(int32_t i = 0; i < firings.size(); i++) {
+		auto found = events_indices.find(firings[i].id);
+		if(found == events_indices.end()) {
+			// Cancelled by a previous call.
+			continue;
+		}
+		Event& event = events[found->second];
+		godot_object* instance = godot::core_1_2_api->godot_instance_from_id(event.instance_id);
+		if(instance == nullptr) {
+			// The target has been freed without cancelling the event.
+			event.done = true;
+			continue;
+		}
+		if(event.emitter != nullptr) {
+			event.emitter->shoot(firings[i].leftover);
+		} else {
+			// The call can push new events, don't keep references to them.
+			String method = event.method;
+			godot::detail::get_wrapper<Object>(instance)->call(method, firings[i].leftover);
+		}
+	}
+
+	for(int32_t i = events.size() - 1; i >= 0; i--) {
+		if(events[i].done) {
+			_remove_at(i);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#ifndef BULLETS_SCHEDULER_H
+#define BULLETS_SCHEDULER_H
+
+#include <Godot.hpp>
+#include <Object.hpp>
+
+#include <vector>
+#include <unordered_map>
+
+using namespace godot;
+
+class BulletsEmitter;
+
+
+// Timed events of the emitters, fired by Bullets in a single pass per physics tick instead of a timer and a signal each.
+// An event fired late by part of a tick reports it as leftover, so that its bullets can be spawned where they would be.
+class BulletsScheduler {
+
+private:
+	struct Event {
+		int64_t id;
+		// Instance ID of the target, checked before each call since the target can be freed at any time.
+		int64_t instance_id;
+		// BulletsEmitter targets are shot natively, the others are called through `method`.
+		BulletsEmitter* emitter;
+		String method;
+		float remaining_time;
+		// Seconds between two calls, 0 for one-shot events.
+		float interval;
+		bool done;
+	};
+	struct Firing {
+		int64_t id;
+		float leftover;
+	};
+	std::vector<Event> events;
+	std::unordered_map<int64_t, int32_t> events_indices;
+	std::vector<Firing> firings;
+	int64_t next_id = 1;
+
+	void _remove_at(int32_t index);
+
+public:
+	// Schedules a call to `method` of `target`, `delay` seconds from now and every `interval` seconds after it.
+	// Returns the ID of the event, used to cancel it.
+	int64_t schedule(Object* target, String method, float delay, float interval);
+	bool cancel(int64_t id);
+	bool set_interval(int64_t id, float interval);
+	bool is_scheduled(int64_t id);
+	void clear();
+	int32_t get_events_amount();
+
+	// Advances all the events and fires the ones that are due, possibly more than once per tick.
+	// Targets can schedule and cancel events while being called.
+	void process(float delta);
+};
+
+#endif
\ No newline at end of file
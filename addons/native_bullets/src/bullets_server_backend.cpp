@@ -0,0 +1,245 @@
+#include <VisualServer.hpp>
+#include <Physics2DServer.hpp>
+#include <Dictionary.hpp>
+
+#include "bullets_server_backend.h"
+
+using namespace godot;
+
+
+BulletsServerBackend* BulletsServerBackend::get_godot_backend() {
+	static GodotServerBackend backend;
+	return &backend;
+}
+
+//-- GodotServerBackend
+
+RID GodotServerBackend::canvas_item_create(RID parent) {
+	RID item = VisualServer::get_singleton()->canvas_item_create();
+	VisualServer::get_singleton()->canvas_item_set_parent(item, parent);
+	return item;
+}
+
+void GodotServerBackend::canvas_item_set_z_index(RID item, int32_t z_index) {
+	VisualServer::get_singleton()->canvas_item_set_z_index(item, z_index);
+}
+
+void GodotServerBackend::canvas_item_set_material(RID item, RID material) {
+	VisualServer::get_singleton()->canvas_item_set_material(item, material);
+}
+
+void GodotServerBackend::canvas_item_set_modulate(RID item, Color color) {
+	VisualServer::get_singleton()->canvas_item_set_modulate(item, color);
+}
+
+void GodotServerBackend::canvas_item_set_transform(RID item, const Transform2D& transform) {
+	VisualServer::get_singleton()->canvas_item_set_transform(item, transform);
+}
+
+void GodotServerBackend::canvas_item_add_texture_rect(RID item, Rect2 rect, RID texture) {
+	VisualServer::get_singleton()->canvas_item_add_texture_rect(item, rect, texture);
+}
+
+void GodotServerBackend::canvas_item_add_multimesh(RID item, RID multimesh, RID texture) {
+	VisualServer::get_singleton()->canvas_item_add_multimesh(item, multimesh, texture);
+}
+
+void GodotServerBackend::canvas_item_clear(RID item) {
+	VisualServer::get_singleton()->canvas_item_clear(item);
+}
+
+void GodotServerBackend::canvas_item_set_visible(RID item, bool visible) {
+	VisualServer::get_singleton()->canvas_item_set_visible(item, visible);
+}
+
+RID GodotServerBackend::mesh_create(const Array& arrays) {
+	RID mesh = VisualServer::get_singleton()->mesh_create();
+	VisualServer::get_singleton()->mesh_add_surface_from_arrays(mesh, VisualServer::PRIMITIVE_TRIANGLES, arrays);
+	return mesh;
+}
+
+RID GodotServerBackend::multimesh_create(RID mesh, int32_t instances) {
+	RID multimesh = VisualServer::get_singleton()->multimesh_create();
+	VisualServer::get_singleton()->multimesh_allocate(multimesh, instances,
+		VisualServer::MULTIMESH_TRANSFORM_2D, VisualServer::MULTIMESH_COLOR_FLOAT);
+	VisualServer::get_singleton()->multimesh_set_mesh(multimesh, mesh);
+	VisualServer::get_singleton()->multimesh_set_visible_instances(multimesh, 0);
+	return multimesh;
+}
+
+void GodotServerBackend::multimesh_set_instances(RID multimesh, const PoolRealArray& buffer, int32_t visible_instances) {
+	VisualServer::get_singleton()->multimesh_set_as_bulk_array(multimesh, buffer);
+	VisualServer::get_singleton()->multimesh_set_visible_instances(multimesh, visible_instances);
+}
+
+void GodotServerBackend::free_rid(RID rid) {
+	VisualServer::get_singleton()->free_rid(rid);
+}
+
+void GodotServerBackend::area_add_shape(RID area, RID shape) {
+	Physics2DServer::get_singleton()->area_add_shape(area, shape, Transform2D(), true);
+}
+
+void GodotServerBackend::area_set_shape_transform(RID area, int32_t shape_index, const Transform2D& transform) {
+	Physics2DServer::get_singleton()->area_set_shape_transform(area, shape_index, transform);
+}
+
+void GodotServerBackend::area_set_shape_disabled(RID area, int32_t shape_index, bool disabled) {
+	Physics2DServer::get_singleton()->area_set_shape_disabled(area, shape_index, disabled);
+}
+
+//-- RecordingServerBackend
+
+RecordingServerBackend::RecordingServerBackend(BulletsServerBackend* target): target(target) {
+	reset();
+}
+
+void RecordingServerBackend::reset() {
+	for(int32_t i = 0; i < CALL_MAX; i++) {
+		calls[i] = 0;
+	}
+}
+
+int64_t RecordingServerBackend::get_calls(Call call) {
+	return calls[call];
+}
+
+int64_t RecordingServerBackend::get_total_calls() {
+	int64_t total = 0;
+	for(int32_t i = 0; i < CALL_MAX; i++) {
+		total += calls[i];
+	}
+	return total;
+}
+
+Dictionary RecordingServerBackend::get_calls_dictionary() {
+	static const char* names[CALL_MAX] = {
+		"canvas_item_create",
+		"canvas_item_set_z_index",
+		"canvas_item_set_material",
+		"canvas_item_set_modulate",
+		"canvas_item_set_transform",
+		"canvas_item_add_texture_rect",
+		"canvas_item_add_multimesh",
+		"canvas_item_clear",
+		"canvas_item_set_visible",
+		"mesh_create",
+		"multimesh_create",
+		"multimesh_set_instances",
+		"free_rid",
+		"area_add_shape",
+		"area_set_shape_transform",
+		"area_set_shape_disabled"
+	};
+	Dictionary dictionary;
+	for(int32_t i = 0; i < CALL_MAX; i++) {
+		dictionary[names[i]] = calls[i];
+	}
+	return dictionary;
+}
+
+RID RecordingServerBackend::canvas_item_create(RID parent) {
+	calls[CANVAS_ITEM_CREATE]++;
+	return target != nullptr ? target->canvas_item_create(parent) : RID();
+}
+
+void RecordingServerBackend::canvas_item_set_z_index(RID item, int32_t z_index) {
+	calls[CANVAS_ITEM_SET_Z_INDEX]++;
+	if(target != nullptr) {
+		target->canvas_item_set_z_index(item, z_index);
+	}
+}
+
+void RecordingServerBackend::canvas_item_set_material(RID item, RID material) {
+	calls[CANVAS_ITEM_SET_MATERIAL]++;
+	if(target != nullptr) {
+		target->canvas_item_set_material(item, material);
+	}
+}
+
+void RecordingServerBackend::canvas_item_set_modulate(RID item, Color color) {
+	calls[CANVAS_ITEM_SET_MODULATE]++;
+	if(target != nullptr) {
+		target->canvas_item_set_modulate(item, color);
+	}
+}
+
+void RecordingServerBackend::canvas_item_set_transform(RID item, const Transform2D& transform) {
+	calls[CANVAS_ITEM_SET_TRANSFORM]++;
+	if(target != nullptr) {
+		target->canvas_item_set_transform(item, transform);
+	}
+}
+
+void RecordingServerBackend::canvas_item_add_texture_rect(RID item, Rect2 rect, RID texture) {
+	calls[CANVAS_ITEM_ADD_TEXTURE_RECT]++;
+	if(target != nullptr) {
+		target->canvas_item_add_texture_rect(item, rect, texture);
+	}
+}
+
+void RecordingServerBackend::canvas_item_add_multimesh(RID item, RID multimesh, RID texture) {
+	calls[CANVAS_ITEM_ADD_MULTIMESH]++;
+	if(target != nullptr) {
+		target->canvas_item_add_multimesh(item, multimesh, texture);
+	}
+}
+
+void RecordingServerBackend::canvas_item_clear(RID item) {
+	calls[CANVAS_ITEM_CLEAR]++;
+	if(target != nullptr) {
+		target->canvas_item_clear(item);
+	}
+}
+
+void RecordingServerBackend::canvas_item_set_visible(RID item, bool visible) {
+	calls[CANVAS_ITEM_SET_VISIBLE]++;
+	if(target != nullptr) {
+		target->canvas_item_set_visible(item, visible);
+	}
+}
+
+RID RecordingServerBackend::mesh_create(const Array& arrays) {
+	calls[MESH_CREATE]++;
+	return target != nullptr ? target->mesh_create(arrays) : RID();
+}
+
+RID RecordingServerBackend::multimesh_create(RID mesh, int32_t instances) {
+	calls[MULTIMESH_CREATE]++;
+	return target != nullptr ? target->multimesh_create(mesh, instances) : RID();
+}
+
+void RecordingServerBackend::multimesh_set_instances(RID multimesh, const PoolRealArray& buffer, int32_t visible_instances) {
+	calls[MULTIMESH_SET_INSTANCES]++;
+	if(target != nullptr) {
+		target->multimesh_set_instances(multimesh, buffer, visible_instances);
+	}
+}
+
+void RecordingServerBackend::free_rid(RID rid) {
+	calls[FREE_RID]++;
+	if(target != nullptr) {
+		target->free_rid(rid);
+	}
+}
+
+void RecordingServerBackend::area_add_shape(RID area, RID shape) {
+	calls[AREA_ADD_SHAPE]++;
+	if(target != nullptr) {
+		target->area_add_shape(area, shape);
+	}
+}
+
+void RecordingServerBackend::area_set_shape_transform(RID area, int32_t shape_index, const Transform2D& transform) {
+	calls[AREA_SET_SHAPE_TRANSFORM]++;
+	if(target != nullptr) {
+		target->area_set_shape_transform(area, shape_index, transform);
+	}
+}
+
+void RecordingServerBackend::area_set_shape_disabled(RID area, int32_t shape_index, bool disabled) {
+	calls[AREA_SET_SHAPE_DISABLED]++;
+	if(target != nullptr) {
+		target->area_set_shape_disabled(area, shape_index, disabled);
+	}
+}
\ No newline at end of file
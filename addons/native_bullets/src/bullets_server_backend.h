@@ -0,0 +1,147 @@
+#ifndef BULLETS_SERVER_BACKEND_H
+#define BULLETS_SERVER_BACKEND_H
+
+#include <Godot.hpp>
+#include <Array.hpp>
+#include <PoolArrays.hpp>
+#include <Color.hpp>
+
+using namespace godot;
+
+
+// Receives the rendering and physics side effects of the bullets pools.
+// Pools never call VisualServer or Physics2DServer directly, so that their logic can run against a different backend.
+// Every method is called on the main thread.
+class BulletsServerBackend {
+
+public:
+	virtual ~BulletsServerBackend() {}
+
+	virtual RID canvas_item_create(RID parent) = 0;
+	virtual void canvas_item_set_z_index(RID item, int32_t z_index) = 0;
+	virtual void canvas_item_set_material(RID item, RID material) = 0;
+	virtual void canvas_item_set_modulate(RID item, Color color) = 0;
+	virtual void canvas_item_set_transform(RID item, const Transform2D& transform) = 0;
+	virtual void canvas_item_add_texture_rect(RID item, Rect2 rect, RID texture) = 0;
+	virtual void canvas_item_add_multimesh(RID item, RID multimesh, RID texture) = 0;
+	virtual void canvas_item_clear(RID item) = 0;
+	virtual void canvas_item_set_visible(RID item, bool visible) = 0;
+	// Creates a mesh made of a single triangles surface.
+	virtual RID mesh_create(const Array& arrays) = 0;
+	// Creates a MultiMesh of 2D transforms and float colors, with no visible instance.
+	virtual RID multimesh_create(RID mesh, int32_t instances) = 0;
+	virtual void multimesh_set_instances(RID multimesh, const PoolRealArray& buffer, int32_t visible_instances) = 0;
+	// Frees a canvas item, a mesh or a MultiMesh.
+	virtual void free_rid(RID rid) = 0;
+
+	virtual void area_add_shape(RID area, RID shape) = 0;
+	virtual void area_set_shape_transform(RID area, int32_t shape_index, const Transform2D& transform) = 0;
+	virtual void area_set_shape_disabled(RID area, int32_t shape_index, bool disabled) = 0;
+
+	// The backend forwarding to the engine servers, used by default.
+	static BulletsServerBackend* get_godot_backend();
+};
+
+// Forwards every call to VisualServer and Physics2DServer.
+class GodotServerBackend : public BulletsServerBackend {
+
+public:
+	RID canvas_item_create(RID parent) override;
+	void canvas_item_set_z_index(RID item, int32_t z_index) override;
+	void canvas_item_set_material(RID item, RID material) override;
+	void canvas_item_set_modulate(RID item, Color color) override;
+	void canvas_item_set_transform(RID item, const Transform2D& transform) override;
+	void canvas_item_add_texture_rect(RID item, Rect2 rect, RID texture) override;
+	void canvas_item_add_multimesh(RID item, RID multimesh, RID texture) override;
+	void canvas_item_clear(RID item) override;
+	void canvas_item_set_visible(RID item, bool visible) override;
+	RID mesh_create(const Array& arrays) override;
+	RID multimesh_create(RID mesh, int32_t instances) override;
+	void multimesh_set_instances(RID multimesh, const PoolRealArray& buffer, int32_t visible_instances) override;
+	void free_rid(RID rid) override;
+
+	void area_add_shape(RID area, RID shape) override;
+	void area_set_shape_transform(RID area, int32_t shape_index, const Transform2D& transform) override;
+	void area_set_shape_disabled(RID area, int32_t shape_index, bool disabled) override;
+};
+
+// Ignores every call, created resources are invalid RIDs. Leaves only the cost of the simulation.
+class NullServerBackend : public BulletsServerBackend {
+
+public:
+	RID canvas_item_create(RID parent) override { return RID(); }
+	void canvas_item_set_z_index(RID item, int32_t z_index) override {}
+	void canvas_item_set_material(RID item, RID material) override {}
+	void canvas_item_set_modulate(RID item, Color color) override {}
+	void canvas_item_set_transform(RID item, const Transform2D& transform) override {}
+	void canvas_item_add_texture_rect(RID item, Rect2 rect, RID texture) override {}
+	void canvas_item_add_multimesh(RID item, RID multimesh, RID texture) override {}
+	void canvas_item_clear(RID item) override {}
+	void canvas_item_set_visible(RID item, bool visible) override {}
+	RID mesh_create(const Array& arrays) override { return RID(); }
+	RID multimesh_create(RID mesh, int32_t instances) override { return RID(); }
+	void multimesh_set_instances(RID multimesh, const PoolRealArray& buffer, int32_t visible_instances) override {}
+	void free_rid(RID rid) override {}
+
+	void area_add_shape(RID area, RID shape) override {}
+	void area_set_shape_transform(RID area, int32_t shape_index, const Transform2D& transform) override {}
+	void area_set_shape_disabled(RID area, int32_t shape_index, bool disabled) override {}
+};
+
+// Counts the calls of each kind, then forwards them to another backend, if any.
+class RecordingServerBackend : public BulletsServerBackend {
+
+public:
+	enum Call {
+		CANVAS_ITEM_CREATE,
+		CANVAS_ITEM_SET_Z_INDEX,
+		CANVAS_ITEM_SET_MATERIAL,
+		CANVAS_ITEM_SET_MODULATE,
+		CANVAS_ITEM_SET_TRANSFORM,
+		CANVAS_ITEM_ADD_TEXTURE_RECT,
+		CANVAS_ITEM_ADD_MULTIMESH,
+		CANVAS_ITEM_CLEAR,
+		CANVAS_ITEM_SET_VISIBLE,
+		MESH_CREATE,
+		MULTIMESH_CREATE,
+		MULTIMESH_SET_INSTANCES,
+		FREE_RID,
+		AREA_ADD_SHAPE,
+		AREA_SET_SHAPE_TRANSFORM,
+		AREA_SET_SHAPE_DISABLED,
+		CALL_MAX
+	};
+
+private:
+	BulletsServerBackend* target;
+	int64_t calls[CALL_MAX];
+
+public:
+	RecordingServerBackend(BulletsServerBackend* target = nullptr);
+
+	void reset();
+	int64_t get_calls(Call call);
+	int64_t get_total_calls();
+	// Returns the amount of calls of each kind, keyed by the server method name.
+	Dictionary get_calls_dictionary();
+
+	RID canvas_item_create(RID parent) override;
+	void canvas_item_set_z_index(RID item, int32_t z_index) override;
+	void canvas_item_set_material(RID item, RID material) override;
+	void canvas_item_set_modulate(RID item, Color color) override;
+	void canvas_item_set_transform(RID item, const Transform2D& transform) override;
+	void canvas_item_add_texture_rect(RID item, Rect2 rect, RID texture) override;
+	void canvas_item_add_multimesh(RID item, RID multimesh, RID texture) override;
+	void canvas_item_clear(RID item) override;
+	void canvas_item_set_visible(RID item, bool visible) override;
+	RID mesh_create(const Array& arrays) override;
+	RID multimesh_create(RID mesh, int32_t instances) override;
+	void multimesh_set_instances(RID multimesh, const PoolRealArray& buffer, int32_t visible_instances) override;
+	void free_rid(RID rid) override;
+
+	void area_add_shape(RID area, RID shape) override;
+	void area_set_shape_transform(RID area, int32_t shape_index, const Transform2D& transform) override;
+	void area_set_shape_disabled(RID area, int32_t shape_index, bool disabled) override;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include "bullets_targets.h"
+
+using namespace godot;
+
+
+Node2D* BulletsTargets::get_node(int64_t instance_id) {
+	if(instance_id == 0) {
+		return nullptr;
+	}
+	godot_object* instance = godot::core_1_2_api->godot_instance_from_id(instance_id);
+	if(instance == nullptr) {
+		return nullptr;
+	}
+	return Object::cast_to<Node2D>(godot::detail::get_wrapper<Object>(instance));
+}
+
+int64_t BulletsTargets::get_id(Node2D* node) {
+	return node != nullptr ? node->get_instance_id() : 0;
+}
+
+void BulletsTargets::update(int64_t* ids, int32_t* slots, int32_t amount) {
+	positions.clear();
+	slots_by_id.clear();
+
+	// Bullets of a pool usually share the same few targets, check the last one before searching.
+	int64_t last_id = 0;
+	int32_t last_slot = -1;
+
+	for(int32_t i = 0; i < amount; i++) {
+		if(ids[i] == 0) {
+			slots[i] = -1;
+			continue;
+		}
+		if(ids[i] != last_id) {
+			auto found = slots_by_id.find(ids[i]);
+			if(found != slots_by_id.end()) {
+				last_slot = found->second;
+			} else {
+				Node2D* node = get_node(ids[i]);
+				if(node == nullptr) {
+					last_slot = -2;
+				} else if(!node->is_inside_tree()) {
+					last_slot = -1;
+				} else {
+					last_slot = positions.size();
+					positions.push_back(node->get_global_position());
+				}
+				slots_by_id[ids[i]] = last_slot;
+			}
+			last_id = ids[i];
+		}
+		if(last_slot == -2) {
+			// The target has been freed, forget it.
+			ids[i] = 0;
+			slots[i] = -1;
+		} else {
+			slots[i] = last_slot;
+		}
+	}
+}
\ No newline at end of file
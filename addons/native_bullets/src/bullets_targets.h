@@ -0,0 +1,33 @@
+#ifndef BULLETS_TARGETS_H
+#define BULLETS_TARGETS_H
+
+#include <Godot.hpp>
+#include <Node2D.hpp>
+
+#include <vector>
+#include <unordered_map>
+
+using namespace godot;
+
+
+// Positions of the nodes followed by the bullets of a pool, resolved once per tick on the main thread.
+// Bullets hold their target by instance ID, so that a freed target is detected instead of being dereferenced.
+class BulletsTargets {
+
+private:
+	std::vector<Vector2> positions;
+	std::unordered_map<int64_t, int32_t> slots_by_id;
+
+public:
+	// Returns the node with the given instance ID, or nullptr if it has been freed or it's not a Node2D.
+	static Node2D* get_node(int64_t instance_id);
+	static int64_t get_id(Node2D* node);
+
+	// Resolves the distinct targets of the first `amount` bullets and writes the slot of each one in `slots`.
+	// Bullets without a target, or whose target is outside the tree, get -1. Freed targets are cleared from `ids`.
+	void update(int64_t* ids, int32_t* slots, int32_t amount);
+
+	inline const Vector2& get_position(int32_t slot) const { return positions[slot]; }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,128 @@
+#include "bullets_thread_pool.h"
+
+
+BulletsThreadPool::BulletsThreadPool() {
+	remaining_jobs = 0;
+}
+
+BulletsThreadPool::~BulletsThreadPool() {
+	stop();
+}
+
+void BulletsThreadPool::start(int32_t threads_amount) {
+	if(threads_amount == get_threads_amount()) {
+		return;
+	}
+	stop();
+
+	queues.clear();
+	for(int32_t i = 0; i <= threads_amount; i++) {
+		queues.push_back(std::unique_ptr<JobsQueue>(new JobsQueue()));
+	}
+	stopping = false;
+	// The last queue belongs to the thread calling parallel_for.
+	for(int32_t i = 0; i < threads_amount; i++) {
+		threads.push_back(std::thread(&BulletsThreadPool::_worker_loop, this, i));
+	}
+}
+
+void BulletsThreadPool::stop() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake_condition.notify_all();
+
+	for(int32_t i = 0; i < threads.size(); i++) {
+		threads[i].join();
+	}
+	threads.clear();
+	queues.clear();
+}
+
+int32_t BulletsThreadPool::get_threads_amount() {
+	return threads.size();
+}
+
+bool BulletsThreadPool::_pop_job(int32_t queue_index, int32_t& job) {
+	JobsQueue* queue = queues[queue_index].get();
+	std::lock_guard<std::mutex> lock(queue->mutex);
+
+	if(queue->jobs.empty()) {
+		return false;
+	}
+	job = queue->jobs.front();
+	queue->jobs.pop_front();
+	return true;
+}
+
+bool BulletsThreadPool::_steal_job(int32_t queue_index, int32_t& job) {
+	// Steal from the back, the jobs the owner would have executed last.
+	for(int32_t i = 1; i < queues.size(); i++) {
+		JobsQueue* queue = queues[(queue_index + i) % queues.size()].get();
+		std::lock_guard<std::mutex> lock(queue->mutex);
+
+		if(!queue->jobs.empty()) {
+			job = queue->jobs.back();
+			queue->jobs.pop_back();
+			return true;
+		}
+	}
+	return false;
+}
+
+void BulletsThreadPool::_run_jobs(int32_t queue_index) {
+	int32_t job;
+	while(_pop_job(queue_index, job) || _steal_job(queue_index, job)) {
+		(*function)(job);
+		remaining_jobs--;
+	}
+}
+
+void BulletsThreadPool::_worker_loop(int32_t queue_index) {
+	uint64_t last_generation = 0;
+
+	while(true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake_condition.wait(lock, [&] { return stopping || generation != last_generation; });
+
+			if(stopping) {
+				return;
+			}
+			last_generation = generation;
+		}
+		_run_jobs(queue_index);
+	}
+}
+
+void BulletsThreadPool::parallel_for(int32_t jobs_amount, const std::function<void(int32_t)>& job_function) {
+	if(threads.empty()) {
+		for(int32_t i = 0; i < jobs_amount; i++) {
+			job_function(i);
+		}
+		return;
+	}
+	function = &job_function;
+	remaining_jobs = jobs_amount;
+
+	// Deal the jobs to every queue, including the calling thread one.
+	for(int32_t i = 0; i < jobs_amount; i++) {
+		JobsQueue* queue = queues[i % queues.size()].get();
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		queue->jobs.push_back(i);
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		generation++;
+	}
+	wake_condition.notify_all();
+
+	_run_jobs(queues.size() - 1);
+
+	// Wait for the jobs other threads are still executing.
+	while(remaining_jobs > 0) {
+		std::this_thread::yield();
+	}
+	function = nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#ifndef BULLETS_THREAD_POOL_H
+#define BULLETS_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// Fixed set of worker threads used to process bullets pools in parallel.
+// Every thread owns a queue of jobs, threads that run out of jobs steal them from the others.
+class BulletsThreadPool {
+
+private:
+	struct JobsQueue {
+		std::mutex mutex;
+		std::deque<int32_t> jobs;
+	};
+
+	std::vector<std::thread> threads;
+	// One queue for each worker thread, plus one for the thread calling parallel_for.
+	std::vector<std::unique_ptr<JobsQueue>> queues;
+
+	std::mutex mutex;
+	std::condition_variable wake_condition;
+	uint64_t generation = 0;
+	bool stopping = false;
+
+	const std::function<void(int32_t)>* function = nullptr;
+	std::atomic<int32_t> remaining_jobs;
+
+	bool _pop_job(int32_t queue_index, int32_t& job);
+	bool _steal_job(int32_t queue_index, int32_t& job);
+	void _run_jobs(int32_t queue_index);
+	void _worker_loop(int32_t queue_index);
+
+public:
+	BulletsThreadPool();
+	~BulletsThreadPool();
+
+	void start(int32_t threads_amount);
+	void stop();
+
+	int32_t get_threads_amount();
+
+	// Calls `job_function` for every job index in [0, jobs_amount) and returns when all of them are completed.
+	// The calling thread takes part in the work.
+	void parallel_for(int32_t jobs_amount, const std::function<void(int32_t)>& job_function);
+};
+
+#endif
\ No newline at end of file
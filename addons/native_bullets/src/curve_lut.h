@@ -0,0 +1,49 @@
+#ifndef CURVE_LUT_H
+#define CURVE_LUT_H
+
+#include <Godot.hpp>
+#include <Curve.hpp>
+
+#include <vector>
+
+using namespace godot;
+
+
+// Lookup table baked from a Curve, so that bullets can sample it without calling into the engine.
+// The curve is sampled at a fixed resolution over [0, 1], values in between are linearly interpolated.
+class CurveLUT {
+
+public:
+	static const int32_t RESOLUTION = 512;
+
+private:
+	// RESOLUTION + 1 samples, the last one is the value at offset 1.
+	std::vector<float> values;
+
+public:
+	// Samples the curve again, an invalid curve empties the table.
+	void bake(const Ref<Curve>& curve) {
+		if(curve.is_null()) {
+			values.clear();
+			return;
+		}
+		values.resize(RESOLUTION + 1);
+		for(int32_t i = 0; i <= RESOLUTION; i++) {
+			values[i] = curve->interpolate((float)i / RESOLUTION);
+		}
+	}
+
+	bool is_baked() const {
+		return !values.empty();
+	}
+
+	// Offsets outside [0, 1] are clamped, like Curve::interpolate does.
+	inline float sample(float offset) const {
+		float position = Math::clamp(offset, 0.0f, 1.0f) * RESOLUTION;
+		int32_t index = Math::min((int32_t)position, RESOLUTION - 1);
+		float weight = position - index;
+		return values[index] + (values[index + 1] - values[index]) * weight;
+	}
+};
+
+#endif
\ No newline at end of file
@@ -1,9 +1,14 @@
 #include "bullets.h"
+#include "bullets_emitter.h"
 #include "kits/basic_bullet_kit.h"
 #include "kits/following_bullet_kit.h"
 #include "kits/dynamic_bullet_kit.h"
 #include "kits/following_dynamic_bullet_kit.h"
 
+#ifdef BULLETS_BENCHMARK
+#include "bench/bullets_benchmark.h"
+#endif
+
 
 extern "C" void GDN_EXPORT godot_gdnative_init(godot_gdnative_init_options *o) {
 	godot::Godot::gdnative_init(o);
@@ -19,6 +24,7 @@ extern "C" void GDN_EXPORT godot_nativescript_init(void *handle) {
 	godot::register_class<Bullet>();
 	godot::register_class<BulletKit>();
 	godot::register_class<Bullets>();
+	godot::register_class<BulletsEmitter>();
 
 	// Default Bullet Kits.
 	godot::register_class<BasicBulletKit>();
@@ -34,4 +40,8 @@ extern "C" void GDN_EXPORT godot_nativescript_init(void *handle) {
 	
 	// Custom Bullet Kits.
 	//godot::register_class<CustomBulletKit>();
+
+#ifdef BULLETS_BENCHMARK
+	godot::register_class<BulletsBenchmark>();
+#endif
 }
\ No newline at end of file
@@ -4,8 +4,10 @@
 #include <Texture.hpp>
 #include <PackedScene.hpp>
 #include <Curve.hpp>
+#include <cmath>
 
 #include "../bullet_kit.h"
+#include "../curve_lut.h"
 
 using namespace godot;
 
@@ -62,6 +64,30 @@ public:
 	bool lifetime_curves_loop = true;
 	Ref<Curve> speed_multiplier_over_lifetime;
 	Ref<Curve> rotation_offset_over_lifetime;
+	// Curves baked by _bake_curves, sampled by the pool while processing.
+	CurveLUT speed_multiplier_lut;
+	CurveLUT rotation_offset_lut;
+
+	void set_speed_multiplier_over_lifetime(Ref<Curve> curve) {
+		_set_curve(speed_multiplier_over_lifetime, curve);
+	}
+
+	Ref<Curve> get_speed_multiplier_over_lifetime() {
+		return speed_multiplier_over_lifetime;
+	}
+
+	void set_rotation_offset_over_lifetime(Ref<Curve> curve) {
+		_set_curve(rotation_offset_over_lifetime, curve);
+	}
+
+	Ref<Curve> get_rotation_offset_over_lifetime() {
+		return rotation_offset_over_lifetime;
+	}
+
+	void _bake_curves() override {
+		speed_multiplier_lut.bake(speed_multiplier_over_lifetime);
+		rotation_offset_lut.bake(rotation_offset_over_lifetime);
+	}
 
 	static void _register_methods() {
 		register_property<DynamicBulletKit, Ref<Texture>>("texture", &DynamicBulletKit::texture, Ref<Texture>(), 
@@ -70,9 +96,13 @@ public:
 			GODOT_METHOD_RPC_MODE_DISABLED, GODOT_PROPERTY_USAGE_DEFAULT, GODOT_PROPERTY_HINT_RANGE, "0.001,256.0");
 		register_property<DynamicBulletKit, bool>("lifetime_curves_loop", &DynamicBulletKit::lifetime_curves_loop, true,
 			GODOT_METHOD_RPC_MODE_DISABLED, GODOT_PROPERTY_USAGE_DEFAULT);
-		register_property<DynamicBulletKit, Ref<Curve>>("speed_multiplier_over_lifetime", &DynamicBulletKit::speed_multiplier_over_lifetime, Ref<Curve>(), 
+		register_property<DynamicBulletKit, Ref<Curve>>("speed_multiplier_over_lifetime",
+			&DynamicBulletKit::set_speed_multiplier_over_lifetime,
+			&DynamicBulletKit::get_speed_multiplier_over_lifetime, Ref<Curve>(), 
 			GODOT_METHOD_RPC_MODE_DISABLED, GODOT_PROPERTY_USAGE_DEFAULT, GODOT_PROPERTY_HINT_RESOURCE_TYPE, "Curve");
-		register_property<DynamicBulletKit, Ref<Curve>>("rotation_offset_over_lifetime", &DynamicBulletKit::rotation_offset_over_lifetime, Ref<Curve>(), 
+		register_property<DynamicBulletKit, Ref<Curve>>("rotation_offset_over_lifetime",
+			&DynamicBulletKit::set_rotation_offset_over_lifetime,
+			&DynamicBulletKit::get_rotation_offset_over_lifetime, Ref<Curve>(), 
 			GODOT_METHOD_RPC_MODE_DISABLED, GODOT_PROPERTY_USAGE_DEFAULT, GODOT_PROPERTY_HINT_RESOURCE_TYPE, "Curve");
 		
 		BULLET_KIT_REGISTRATION(DynamicBulletKit, DynamicBullet)
@@ -82,54 +112,71 @@ public:
 // Bullets pool definition.
 class DynamicBulletsPool : public AbstractBulletsPool<DynamicBulletKit, DynamicBullet> {
 
-	// void _init_bullet(Bullet* bullet); Use default implementation.
+	// Additional columns, bound to the DynamicBullet properties.
+	BulletsColumn<DynamicBullet, Transform2D> starting_transforms = &DynamicBullet::starting_trasform;
+	BulletsColumn<DynamicBullet, float> starting_speeds = &DynamicBullet::starting_speed;
 
-	void _enable_bullet(DynamicBullet* bullet) {
+	// void _init_bullet(int32_t index); Use default implementation.
+
+	void _enable_bullet(int32_t index) {
 		// Reset the bullet lifetime.
-		bullet->lifetime = 0.0f;
-		Rect2 texture_rect = Rect2(-kit->texture->get_size() / 2.0f, kit->texture->get_size());
-		RID texture_rid = kit->texture->get_rid();
-		
-		// Configure the bullet to draw the kit texture each frame.
-		VisualServer::get_singleton()->canvas_item_add_texture_rect(bullet->item_rid,
-			texture_rect,
-			texture_rid);
+		lifetimes[index] = 0.0f;
+	}
+
+	// void _disable_bullet(int32_t index); Use default implementation.
+
+	void _init_spawned_bullet(int32_t index) {
+		// Same values the bullet setters derive when spawning through a Dictionary.
+		starting_transforms[index] = transforms[index];
+		starting_speeds[index] = velocities[index].length();
 	}
 
-	// void _disable_bullet(Bullet* bullet); Use default implementation.
+	bool _process_bullet(int32_t index, float delta) {
+		Transform2D& transform = transforms[index];
+		Vector2& velocity = velocities[index];
 
-	bool _process_bullet(DynamicBullet* bullet, float delta) {
-		float adjusted_lifetime = bullet->lifetime / kit->lifetime_curves_span;
+		float adjusted_lifetime = lifetimes[index] / kit->lifetime_curves_span;
 		if(kit->lifetime_curves_loop) {
-			adjusted_lifetime = fmod(adjusted_lifetime, 1.0f);
+			// Lifetimes are never negative, this is the same as fmod(adjusted_lifetime, 1.0f).
+			adjusted_lifetime -= std::floor(adjusted_lifetime);
 		}
 
-		if(kit->speed_multiplier_over_lifetime.is_valid()) {
-			float speed_multiplier = kit->speed_multiplier_over_lifetime->interpolate(adjusted_lifetime);
-			bullet->velocity = bullet->velocity.normalized() * bullet->starting_speed * speed_multiplier;
+		if(kit->speed_multiplier_lut.is_baked()) {
+			float speed_multiplier = kit->speed_multiplier_lut.sample(adjusted_lifetime);
+			velocity = velocity.normalized() * starting_speeds[index] * speed_multiplier;
 		}
-		if(kit->rotation_offset_over_lifetime.is_valid()) {
-			float rotation_offset = kit->rotation_offset_over_lifetime->interpolate(adjusted_lifetime);
-			float absolute_rotation = bullet->starting_trasform.get_rotation() + rotation_offset;
+		if(kit->rotation_offset_lut.is_baked()) {
+			float rotation_offset = kit->rotation_offset_lut.sample(adjusted_lifetime);
+			float absolute_rotation = starting_transforms[index].get_rotation() + rotation_offset;
 
-			bullet->velocity = bullet->velocity.rotated(absolute_rotation - bullet->transform.get_rotation());
+			velocity = velocity.rotated(absolute_rotation - transform.get_rotation());
 		}
 
-		bullet->transform.set_origin(bullet->transform.get_origin() + bullet->velocity * delta);
+		transform.set_origin(transform.get_origin() + velocity * delta);
 
-		if(!active_rect.has_point(bullet->transform.get_origin())) {
+		if(!active_rect.has_point(transform.get_origin())) {
 			// Return true if the bullet should be deleted.
 			return true;
 		}
 		// Rotate the bullet based on its velocity "rotate" is enabled.
 		if(kit->rotate) {
-			bullet->transform.set_rotation(bullet->velocity.angle());
+			transform.set_rotation(velocity.angle());
 		}
 		// Bullet is still alive, increase its lifetime.
-		bullet->lifetime += delta;
+		lifetimes[index] += delta;
 		// Return false if the bullet should not be deleted yet.
 		return false;
 	}
+
+public:
+	bool _is_thread_safe() override {
+		return true;
+	}
+
+	DynamicBulletsPool() {
+		_add_column(&starting_transforms);
+		_add_column(&starting_speeds);
+	}
 };
 
 BULLET_KIT_IMPLEMENTATION(DynamicBulletKit, DynamicBulletsPool)
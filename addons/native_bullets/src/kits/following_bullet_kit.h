@@ -8,6 +8,7 @@
 #include <cmath>
 
 #include "../bullet_kit.h"
+#include "../bullets_targets.h"
 
 using namespace godot;
 
@@ -16,16 +17,17 @@ using namespace godot;
 class FollowingBullet : public Bullet {
 	GODOT_CLASS(FollowingBullet, Bullet)
 public:
-	Node2D* target_node = nullptr;
+	// Instance ID of the target node, 0 if there is none.
+	int64_t target_id = 0;
 
 	void _init() {}
 
 	void set_target_node(Node2D* node) {
-		target_node = node;
+		target_id = BulletsTargets::get_id(node);
 	}
 
 	Node2D* get_target_node() {
-		return target_node;
+		return BulletsTargets::get_node(target_id);
 	}
 
 	static void _register_methods() {
@@ -60,48 +62,70 @@ public:
 // Bullets pool definition.
 class FollowingBulletsPool : public AbstractBulletsPool<FollowingBulletKit, FollowingBullet> {
 
-	//void _init_bullet(FollowingBullet* bullet); Use default implementation.
+	// Additional columns, bound to the FollowingBullet properties.
+	BulletsColumn<FollowingBullet, int64_t> target_ids = &FollowingBullet::target_id;
+	// Slot of the target of each active bullet in the targets cache, -1 if the bullet has no target this tick.
+	std::vector<int32_t> target_slots;
+	BulletsTargets targets;
 
-	void _enable_bullet(FollowingBullet* bullet) {
+	//void _init_bullet(int32_t index); Use default implementation.
+
+	void _enable_bullet(int32_t index) {
 		// Reset the bullet lifetime.
-		bullet->lifetime = 0.0f;
-		Rect2 texture_rect = Rect2(-kit->texture->get_size() / 2.0f, kit->texture->get_size());
-		RID texture_rid = kit->texture->get_rid();
-		
-		// Configure the bullet to draw the kit texture each frame.
-		VisualServer::get_singleton()->canvas_item_add_texture_rect(bullet->item_rid,
-			texture_rect,
-			texture_rid);
+		lifetimes[index] = 0.0f;
+	}
+
+	//void _disable_bullet(int32_t index); Use default implementation.
+
+	void _init_spawned_bullet(int32_t index) {
+		// Batch spawned bullets have no target.
+		target_ids[index] = 0;
 	}
 
-	//void _disable_bullet(FollowingBullet* bullet); Use default implementation.
+	bool _process_bullet(int32_t index, float delta) {
+		Transform2D& transform = transforms[index];
+		Vector2& velocity = velocities[index];
 
-	bool _process_bullet(FollowingBullet* bullet, float delta) {
-		if(bullet->target_node != nullptr) {
+		if(target_slots[index] >= 0) {
 			// Find the rotation to the target node.
-			Vector2 to_target = bullet->target_node->get_global_position() - bullet->transform.get_origin();
-			float rotation_to_target = bullet->velocity.angle_to(to_target);
+			Vector2 to_target = targets.get_position(target_slots[index]) - transform.get_origin();
+			float rotation_to_target = velocity.angle_to(to_target);
 			float rotation_value = Math::min(kit->bullets_turning_speed * delta, std::abs(rotation_to_target));
 
 			// Apply the rotation, capped to the max turning speed.
-			bullet->velocity = bullet->velocity.rotated(Math::sign(rotation_to_target) * rotation_value);
+			velocity = velocity.rotated(Math::sign(rotation_to_target) * rotation_value);
 		}
 		// Apply velocity.
-		bullet->transform.set_origin(bullet->transform.get_origin() + bullet->velocity * delta);
+		transform.set_origin(transform.get_origin() + velocity * delta);
 
-		if(!active_rect.has_point(bullet->transform.get_origin())) {
+		if(!active_rect.has_point(transform.get_origin())) {
 			// Return true if the bullet should be deleted.
 			return true;
 		}
 		// Rotate the bullet based on its velocity "rotate" is enabled.
 		if(kit->rotate) {
-			bullet->transform.set_rotation(bullet->velocity.angle());
+			transform.set_rotation(velocity.angle());
 		}
 		// Bullet is still alive, increase its lifetime.
-		bullet->lifetime += delta;
+		lifetimes[index] += delta;
 		// Return false if the bullet should not be deleted yet.
 		return false;
 	}
+
+public:
+	bool _is_thread_safe() override {
+		return true;
+	}
+
+	// Target nodes are resolved here, so that processing never calls into the engine.
+	void _prepare_simulation() override {
+		target_slots.resize(pool_size);
+		targets.update(target_ids.data(), target_slots.data(), active_bullets);
+	}
+
+	FollowingBulletsPool() {
+		_add_column(&target_ids);
+	}
 };
 
 BULLET_KIT_IMPLEMENTATION(FollowingBulletKit, FollowingBulletsPool)
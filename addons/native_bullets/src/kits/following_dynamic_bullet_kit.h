@@ -5,8 +5,11 @@
 #include <PackedScene.hpp>
 #include <Curve.hpp>
 #include <Node2D.hpp>
+#include <cmath>
 
 #include "../bullet_kit.h"
+#include "../curve_lut.h"
+#include "../bullets_targets.h"
 
 using namespace godot;
 
@@ -15,15 +18,16 @@ using namespace godot;
 class FollowingDynamicBullet : public Bullet {
 	GODOT_CLASS(FollowingDynamicBullet, Bullet)
 public:
-	Node2D* target_node = nullptr;
+	// Instance ID of the target node, 0 if there is none.
+	int64_t target_id = 0;
 	float starting_speed;
 
 	void set_target_node(Node2D* node) {
-		target_node = node;
+		target_id = BulletsTargets::get_id(node);
 	}
 
 	Node2D* get_target_node() {
-		return target_node;
+		return BulletsTargets::get_node(target_id);
 	}
 
 	void set_velocity(Vector2 velocity) {
@@ -66,6 +70,30 @@ public:
 	Ref<Curve> speed_multiplier;
 	int32_t turning_speed_control_mode = 0;
 	Ref<Curve> turning_speed;
+	// Curves baked by _bake_curves, sampled by the pool while processing.
+	CurveLUT speed_multiplier_lut;
+	CurveLUT turning_speed_lut;
+
+	void set_speed_multiplier(Ref<Curve> curve) {
+		_set_curve(speed_multiplier, curve);
+	}
+
+	Ref<Curve> get_speed_multiplier() {
+		return speed_multiplier;
+	}
+
+	void set_turning_speed(Ref<Curve> curve) {
+		_set_curve(turning_speed, curve);
+	}
+
+	Ref<Curve> get_turning_speed() {
+		return turning_speed;
+	}
+
+	void _bake_curves() override {
+		speed_multiplier_lut.bake(speed_multiplier);
+		turning_speed_lut.bake(turning_speed);
+	}
 
 	static void _register_methods() {
 		register_property<FollowingDynamicBulletKit, Ref<Texture>>("texture", &FollowingDynamicBulletKit::texture, Ref<Texture>(), 
@@ -80,14 +108,16 @@ public:
 			GODOT_METHOD_RPC_MODE_DISABLED, GODOT_PROPERTY_USAGE_DEFAULT, GODOT_PROPERTY_HINT_ENUM,
 			"Based On Lifetime,Based On Target Distance,Based On Angle To Target");
 		register_property<FollowingDynamicBulletKit, Ref<Curve>>("speed_multiplier",
-			&FollowingDynamicBulletKit::speed_multiplier, Ref<Curve>(), 
+			&FollowingDynamicBulletKit::set_speed_multiplier,
+			&FollowingDynamicBulletKit::get_speed_multiplier, Ref<Curve>(), 
 			GODOT_METHOD_RPC_MODE_DISABLED, GODOT_PROPERTY_USAGE_DEFAULT, GODOT_PROPERTY_HINT_RESOURCE_TYPE, "Curve");
 		register_property<FollowingDynamicBulletKit, int32_t>("turning_speed_control_mode",
 			&FollowingDynamicBulletKit::turning_speed_control_mode, 0,
 			GODOT_METHOD_RPC_MODE_DISABLED, GODOT_PROPERTY_USAGE_DEFAULT, GODOT_PROPERTY_HINT_ENUM,
 			"Based On Lifetime,Based On Target Distance,Based On Angle To Target");
 		register_property<FollowingDynamicBulletKit, Ref<Curve>>("turning_speed",
-			&FollowingDynamicBulletKit::turning_speed, Ref<Curve>(), 
+			&FollowingDynamicBulletKit::set_turning_speed,
+			&FollowingDynamicBulletKit::get_turning_speed, Ref<Curve>(), 
 			GODOT_METHOD_RPC_MODE_DISABLED, GODOT_PROPERTY_USAGE_DEFAULT, GODOT_PROPERTY_HINT_RESOURCE_TYPE, "Curve");
 		
 		BULLET_KIT_REGISTRATION(FollowingDynamicBulletKit, FollowingDynamicBullet)
@@ -97,95 +127,121 @@ public:
 // Bullets pool definition.
 class FollowingDynamicBulletsPool : public AbstractBulletsPool<FollowingDynamicBulletKit, FollowingDynamicBullet> {
 
-	// void _init_bullet(FollowingDynamicBullet* bullet); Use default implementation.
+	// Additional columns, bound to the FollowingDynamicBullet properties.
+	BulletsColumn<FollowingDynamicBullet, int64_t> target_ids = &FollowingDynamicBullet::target_id;
+	BulletsColumn<FollowingDynamicBullet, float> starting_speeds = &FollowingDynamicBullet::starting_speed;
+	// Slot of the target of each active bullet in the targets cache, -1 if the bullet has no target this tick.
+	std::vector<int32_t> target_slots;
+	BulletsTargets targets;
+
+	// void _init_bullet(int32_t index); Use default implementation.
 
-	void _enable_bullet(FollowingDynamicBullet* bullet) {
+	void _enable_bullet(int32_t index) {
 		// Reset the bullet lifetime.
-		bullet->lifetime = 0.0f;
-		Rect2 texture_rect = Rect2(-kit->texture->get_size() / 2.0f, kit->texture->get_size());
-		RID texture_rid = kit->texture->get_rid();
-		
-		// Configure the bullet to draw the kit texture each frame.
-		VisualServer::get_singleton()->canvas_item_add_texture_rect(bullet->item_rid,
-			texture_rect,
-			texture_rid);
+		lifetimes[index] = 0.0f;
+	}
+
+	// void _disable_bullet(int32_t index); Use default implementation.
+
+	void _init_spawned_bullet(int32_t index) {
+		// Batch spawned bullets have no target, the starting speed is derived like the velocity setter does.
+		target_ids[index] = 0;
+		starting_speeds[index] = velocities[index].length();
 	}
 
-	// void _disable_bullet(FollowingDynamicBullet* bullet); Use default implementation.
+	bool _process_bullet(int32_t index, float delta) {
+		Transform2D& transform = transforms[index];
+		Vector2& velocity = velocities[index];
+		bool has_target = target_slots[index] >= 0;
+		// The target position is read once, the curves and the steering all use the same vector.
+		Vector2 to_target = has_target ? targets.get_position(target_slots[index]) - transform.get_origin() : Vector2();
 
-	bool _process_bullet(FollowingDynamicBullet* bullet, float delta) {
-		float adjusted_lifetime = bullet->lifetime / kit->lifetime_curves_span;
+		float adjusted_lifetime = lifetimes[index] / kit->lifetime_curves_span;
 		if(kit->lifetime_curves_loop) {
-			adjusted_lifetime = fmod(adjusted_lifetime, 1.0f);
+			// Lifetimes are never negative, this is the same as fmod(adjusted_lifetime, 1.0f).
+			adjusted_lifetime -= std::floor(adjusted_lifetime);
 		}
 		float bullet_turning_speed = 0.0f;
 		float speed_multiplier = 1.0f;
 		
-		if(kit->turning_speed.is_valid() && bullet->target_node != nullptr) {
-			Vector2 to_target = bullet->target_node->get_global_position() - bullet->transform.get_origin();
+		if(kit->turning_speed_lut.is_baked() && has_target) {
 			// If based on lifetime.
 			if(kit->turning_speed_control_mode == 0) {
-				bullet_turning_speed = kit->turning_speed->interpolate(adjusted_lifetime);
+				bullet_turning_speed = kit->turning_speed_lut.sample(adjusted_lifetime);
 			}
 			// If based on distance to target.
 			else if(kit->turning_speed_control_mode == 1) {
 				float distance_to_target = to_target.length();
-				bullet_turning_speed = kit->turning_speed->interpolate(distance_to_target / kit->distance_curves_span);
+				bullet_turning_speed = kit->turning_speed_lut.sample(distance_to_target / kit->distance_curves_span);
 			}
 			// If based on angle to target.
 			else if(kit->turning_speed_control_mode == 2) {
-				float angle_to_target = bullet->velocity.angle_to(to_target);
-				bullet_turning_speed = kit->turning_speed->interpolate(std::abs(angle_to_target) / (float)Math_PI);
+				float angle_to_target = velocity.angle_to(to_target);
+				bullet_turning_speed = kit->turning_speed_lut.sample(std::abs(angle_to_target) / (float)Math_PI);
 			}
 		}
-		if(kit->speed_multiplier.is_valid()) {
+		if(kit->speed_multiplier_lut.is_baked()) {
 			// If based on lifetime.
 			if(kit->speed_control_mode <= 0) {
-				speed_multiplier = kit->speed_multiplier->interpolate(adjusted_lifetime);
+				speed_multiplier = kit->speed_multiplier_lut.sample(adjusted_lifetime);
 			}
 			// If based on target node: 1 or 2.
-			else if(kit->speed_control_mode < 3 && bullet->target_node != nullptr) {
-				Vector2 to_target = bullet->target_node->get_global_position() - bullet->transform.get_origin();
+			else if(kit->speed_control_mode < 3 && has_target) {
 				// If based on distance to target.
 				if(kit->speed_control_mode == 1) {
 					float distance_to_target = to_target.length();
-					speed_multiplier = kit->speed_multiplier->interpolate(distance_to_target / kit->distance_curves_span);
+					speed_multiplier = kit->speed_multiplier_lut.sample(distance_to_target / kit->distance_curves_span);
 				}
 				// If based on angle to target.
 				else if(kit->speed_control_mode == 2) {
-					float angle_to_target = bullet->velocity.angle_to(to_target);
-					speed_multiplier = kit->speed_multiplier->interpolate(std::abs(angle_to_target) / (float)Math_PI);
+					float angle_to_target = velocity.angle_to(to_target);
+					speed_multiplier = kit->speed_multiplier_lut.sample(std::abs(angle_to_target) / (float)Math_PI);
 				}
 			}
 		}
 
 		if(speed_multiplier != 1.0f) {
-			bullet->velocity = bullet->velocity.normalized() * bullet->starting_speed * speed_multiplier;
+			velocity = velocity.normalized() * starting_speeds[index] * speed_multiplier;
 		}
-		if(bullet_turning_speed != 0.0 && bullet->target_node != nullptr) {
+		if(bullet_turning_speed != 0.0 && has_target) {
 			// Find the rotation to the target node.
-			Vector2 to_target = bullet->target_node->get_global_position() - bullet->transform.get_origin();
-			float rotation_to_target = bullet->velocity.angle_to(to_target);
+			float rotation_to_target = velocity.angle_to(to_target);
 			float rotation_value = Math::min(bullet_turning_speed * delta, std::abs(rotation_to_target));
 			// Apply the rotation, capped to the max turning speed.
-			bullet->velocity = bullet->velocity.rotated(Math::sign(rotation_to_target) * rotation_value);
+			velocity = velocity.rotated(Math::sign(rotation_to_target) * rotation_value);
 		}
 
-		bullet->transform.set_origin(bullet->transform.get_origin() + bullet->velocity * delta);
+		transform.set_origin(transform.get_origin() + velocity * delta);
 
-		if(!active_rect.has_point(bullet->transform.get_origin())) {
+		if(!active_rect.has_point(transform.get_origin())) {
 			// Return true if the bullet should be deleted.
 			return true;
 		}
 		// Rotate the bullet based on its velocity "rotate" is enabled.
 		if(kit->rotate) {
-			bullet->transform.set_rotation(bullet->velocity.angle());
+			transform.set_rotation(velocity.angle());
 		}
 		// Bullet is still alive, increase its lifetime.
-		bullet->lifetime += delta;
+		lifetimes[index] += delta;
 		// Return false if the bullet should not be deleted yet.
 		return false;
 	}
+
+public:
+	bool _is_thread_safe() override {
+		return true;
+	}
+
+	// Target nodes are resolved here, so that processing never calls into the engine.
+	void _prepare_simulation() override {
+		target_slots.resize(pool_size);
+		targets.update(target_ids.data(), target_slots.data(), active_bullets);
+	}
+
+	FollowingDynamicBulletsPool() {
+		_add_column(&target_ids);
+		_add_column(&starting_speeds);
+	}
 };
 
 BULLET_KIT_IMPLEMENTATION(FollowingDynamicBulletKit, FollowingDynamicBulletsPool)